@@ -1,7 +1,10 @@
 #pragma once
 
 #include "tui.hpp"
+#include <algorithm>
+#include <cstddef>
 #include <random>
+#include <string>
 #include <utility>
 
 // NOTE: full-screen iteration goes:
@@ -75,7 +78,7 @@ struct Coord {
     std::string display() const { return "(" + std::to_string(this->row) + ";" + std::to_string(this->col) + ")"; }
 
     // set cursor to this `Coord` on the screen
-    void set_cursor() const { tui::cursor::set_position(this->row, this->col); }
+    void set_cursor() const { tui::cursor::move_to(this->row, this->col); }
 
     // print to `stdout` starting from this `Coord`
     template <typename T> void print(const T& print) const {
@@ -83,3 +86,47 @@ struct Coord {
         std::cout << print;
     }
 };
+
+// the cells from `start` to `end`, both included, eg. the area to redraw (see `tui::Frame::damage()`)
+struct Rect {
+    Coord start{1, 1};
+    // empty by default
+    Coord end{0, 0};
+
+    Rect() = default;
+    Rect(const Coord& start, const Coord& end) : start{start}, end{end} {}
+
+    bool empty() const { return (this->start.row > this->end.row || this->start.col > this->end.col); }
+    unsigned rows() const { return this->empty() ? 0 : this->end.row - this->start.row + 1; }
+    unsigned cols() const { return this->empty() ? 0 : this->end.col - this->start.col + 1; }
+    size_t area() const { return static_cast<size_t>(this->rows()) * this->cols(); }
+
+    bool contains(const Coord& coord) const { return (this->start <= coord && coord <= this->end); }
+    bool intersects(const Rect& other) const { return !this->intersection(other).empty(); }
+
+    // the cells in both, empty if none
+    Rect intersection(const Rect& other) const {
+        return Rect{
+            Coord{std::max(this->start.row, other.start.row), std::max(this->start.col, other.start.col)},
+            Coord{std::min(this->end.row, other.end.row), std::min(this->end.col, other.end.col)},
+        };
+    }
+    // the smallest one containing both
+    Rect merged(const Rect& other) const {
+        if (this->empty()) {
+            return other;
+        }
+        if (other.empty()) {
+            return *this;
+        }
+        return Rect{
+            Coord{std::min(this->start.row, other.start.row), std::min(this->start.col, other.start.col)},
+            Coord{std::max(this->end.row, other.end.row), std::max(this->end.col, other.end.col)},
+        };
+    }
+
+    bool operator==(const Rect& other) const { return (this->start == other.start && this->end == other.end); }
+    bool operator!=(const Rect& other) const { return !(*this == other); }
+
+    std::string display() const { return this->start.display() + "-" + this->end.display(); }
+};
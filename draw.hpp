@@ -0,0 +1,151 @@
+#pragma once
+
+#include "coords.hpp"
+#include "tui.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// NOTE: drawing straight to the terminal, without a `tui::Frame`, goes:
+// ```c++
+// tui::output().attach();
+// tui::draw::fill(tui::draw::screen(), tui::Style().on_blue());         // one move per row
+// tui::draw::rect({{2, 3}, {10, 40}}, tui::Style().bold(), tui::draw::Border::Rounded);
+// std::cout.flush();
+// ```
+// each row is written with a single cursor move and each call switches the style once, everything is clipped
+// to the screen (or the `clip` given)
+namespace tui {
+    namespace draw {
+        enum class Border : std::uint8_t {
+            Basic = 0,
+            Bold = 1,
+            Rounded = 2,
+            Double = 3,
+        };
+
+        // the utf-8 encoded pieces of a `Border`, each a single column wide
+        struct BorderGlyphs {
+            const char* top_left;
+            const char* top_right;
+            const char* bottom_left;
+            const char* bottom_right;
+            const char* vertical;
+            const char* horizontal;
+        };
+
+        inline const BorderGlyphs& glyphs(Border border) {
+            static const BorderGlyphs GLYPHS[] = {
+                {"┌", "┐", "└", "┘", "│", "─"},
+                {"┏", "┓", "┗", "┛", "┃", "━"},
+                {"╭", "╮", "╰", "╯", "│", "─"},
+                {"╔", "╗", "╚", "╝", "║", "═"},
+            };
+            return GLYPHS[static_cast<size_t>(border)];
+        }
+
+        // (1;1)-`Coord::screen_size()`
+        inline Rect screen() { return Rect{Coord::origin(), Coord::screen_size()}; }
+
+        // switch the terminal to `style`, only what changes if the output arena is attached
+        // NOTE: it's left on, like after `Output::print()`
+        inline void style(const Style& style) {
+            if (output().attached()) {
+                output().style(style);
+                return;
+            }
+            // the terminal's style is unknown, so it's written in full
+            SgrState sgr;
+            char seq[encode::MAX_SEQ];
+            put(seq, sgr.style(seq, style));
+        }
+
+        // the part of `row` from `from` to `to` (columns) inside `clip`, with a single move and a single write:
+        // `left` at `from`, `right` at `to` and `middle` in between
+        inline void run(unsigned row, unsigned from, unsigned to, const Rect& clip, const char* left,
+                        const char* middle, const char* right) {
+            if (row < clip.start.row || row > clip.end.row) {
+                return;
+            }
+            auto first = (from > clip.start.col) ? from : clip.start.col;
+            auto last = (to < clip.end.col) ? to : clip.end.col;
+            if (first > last) {
+                return;
+            }
+            std::string line;
+            line.reserve(static_cast<size_t>(last - first + 1) * std::char_traits<char>::length(middle));
+            for (auto col = first; col <= last; ++col) {
+                line += (col == from) ? left : (col == to) ? right : middle;
+            }
+            tui::cursor::move_to(row, first);
+            std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+        }
+
+        // fill `rect` with `glyph`, which has to be a single column wide, a space by default
+        inline void fill(const Rect& rect, const Style& style = Style(), const std::string& glyph = " ",
+                         const Rect& clip = screen()) {
+            auto area = rect.intersection(clip);
+            if (area.empty()) {
+                return;
+            }
+            draw::style(style);
+            // the same for every row
+            std::string line;
+            line.reserve(glyph.size() * area.cols());
+            for (unsigned col = 0; col < area.cols(); ++col) {
+                line += glyph;
+            }
+            for (auto row = area.start.row; row <= area.end.row; ++row) {
+                tui::cursor::move_to(row, area.start.col);
+                std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+            }
+        }
+
+        // a horizontal line of `cols` from `start` to the right
+        inline void hline(const Coord& start, unsigned cols, const Style& style = Style(),
+                          Border border = Border::Basic, const Rect& clip = screen()) {
+            if (cols == 0) {
+                return;
+            }
+            const auto* glyph = glyphs(border).horizontal;
+            draw::style(style);
+            run(start.row, start.col, start.col + cols - 1, clip, glyph, glyph, glyph);
+        }
+
+        // a vertical line of `rows` from `start` down, a move for each row
+        inline void vline(const Coord& start, unsigned rows, const Style& style = Style(),
+                          Border border = Border::Basic, const Rect& clip = screen()) {
+            if (rows == 0 || start.col < clip.start.col || start.col > clip.end.col) {
+                return;
+            }
+            const auto* glyph = glyphs(border).vertical;
+            draw::style(style);
+            for (auto row = start.row; row < start.row + rows; ++row) {
+                run(row, start.col, start.col, clip, glyph, glyph, glyph);
+            }
+        }
+
+        // the border of `rect`, its inside is left as it is
+        inline void rect(const Rect& rect, const Style& style = Style(), Border border = Border::Basic,
+                         const Rect& clip = screen()) {
+            if (rect.empty() || !rect.intersects(clip)) {
+                return;
+            }
+            const auto& glyph = glyphs(border);
+            draw::style(style);
+            const auto& start = rect.start;
+            const auto& end = rect.end;
+            run(start.row, start.col, end.col, clip, glyph.top_left, glyph.horizontal, glyph.top_right);
+            for (auto row = start.row + 1; row < end.row; ++row) {
+                run(row, start.col, start.col, clip, glyph.vertical, glyph.vertical, glyph.vertical);
+                if (end.col != start.col) {
+                    run(row, end.col, end.col, clip, glyph.vertical, glyph.vertical, glyph.vertical);
+                }
+            }
+            if (end.row > start.row) {
+                run(end.row, start.col, end.col, clip, glyph.bottom_left, glyph.horizontal, glyph.bottom_right);
+            }
+        }
+    } // namespace draw
+} // namespace tui
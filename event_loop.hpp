@@ -0,0 +1,340 @@
+#pragma once
+
+#include "input.hpp"
+#include "tui.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#ifdef _WIN32
+#include <conio.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <err.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// NOTE: a whole app on a single thread goes:
+// ```c++
+// tui::EventLoop loop;
+// auto tick = loop.add_timer(100);             // every 100ms
+// while (true) {
+//     auto event = loop.wait_event();          // blocks without using any cpu until something happens
+//     if (event.kind == tui::Event::Kind::Input && event.input == 'q') {
+//         break;
+//     }
+//     if (event.kind == tui::Event::Kind::Resize) { ... }
+//     if (event.kind == tui::Event::Kind::Timer && event.timer == tick) { ... }
+// }
+// ```
+namespace tui {
+    struct Event {
+        enum class Kind : std::uint8_t {
+            // nothing happened until the timeout
+            None = 0,
+            Input,
+            // the terminal was resized, maybe several times since the last one
+            Resize,
+            Timer,
+            // a `watch()`-ed file descriptor is ready
+            Fd,
+            // `EventLoop::wake()` was called
+            Wake,
+        };
+
+        Kind kind = Kind::None;
+        // `Kind::Input`
+        // WARN: `Input::paste` is only valid until the next `wait_event()`
+        ::Input input;
+        // `Kind::Timer`: what `add_timer()` returned
+        unsigned timer = 0;
+        // `Kind::Fd`: the ready file descriptor and its `poll()` `revents`
+        int fd = -1;
+        short revents = 0;
+
+        Event() = default;
+        explicit Event(Kind kind) : kind(kind) {}
+        explicit Event(const ::Input& input) : kind(Kind::Input), input(input) {}
+    };
+
+    // waits for input, terminal resizes, timers and any other file descriptors on a single thread
+    // with `poll()`, so there's no added latency and no cpu used while idle
+    // NOTE: only one `EventLoop` at a time is notified of resizes
+    // WARN: `watch()` does not work on windows
+    class EventLoop {
+        using clock = std::chrono::steady_clock;
+
+        struct Timer {
+            unsigned id;
+            clock::time_point next;
+            clock::duration interval;
+            bool repeat;
+        };
+
+        std::vector<Timer> timers_;
+        unsigned last_timer_ = 0;
+        std::atomic<bool> woken_{false};
+#ifdef _WIN32
+        // signaled by `wake()`, waited for along with the console input
+        HANDLE wake_event_;
+#else
+        int input_fd_;
+        InputReader reader_;
+        // [read end, write end], written by the SIGWINCH handler and `wake()`
+        int pipe_[2] = {-1, -1};
+        std::vector<int> fds_;
+        std::vector<struct pollfd> pfds_;
+        // `screen::resizes()` the last time a `Kind::Resize` was returned
+        unsigned resizes_ = 0;
+        // until when an incomplete escape sequence may wait for the rest
+        clock::time_point partial_until_;
+#endif
+
+        // return the earliest due timer, if any
+        bool due_timer(Event& event, clock::time_point now) {
+            auto earliest = this->timers_.end();
+            for (auto it = this->timers_.begin(); it != this->timers_.end(); ++it) {
+                if (it->next <= now && (earliest == this->timers_.end() || it->next < earliest->next)) {
+                    earliest = it;
+                }
+            }
+            if (earliest == this->timers_.end()) {
+                return false;
+            }
+            event = Event(Event::Kind::Timer);
+            event.timer = earliest->id;
+            if (!earliest->repeat) {
+                this->timers_.erase(earliest);
+            } else {
+                earliest->next += earliest->interval;
+                // fell behind, skip the missed ticks instead of firing them all at once
+                if (earliest->next <= now) {
+                    earliest->next = now + earliest->interval;
+                }
+            }
+            return true;
+        }
+
+        // something that doesn't need waiting for
+        bool pending(Event& event, clock::time_point now) {
+#ifndef _WIN32
+            ::Input input;
+            if (this->reader_.next(input)) {
+                event = Event(input);
+                return true;
+            }
+            if (this->reader_.pending() && now >= this->partial_until_ && this->reader_.next(input, true)) {
+                event = Event(input);
+                return true;
+            }
+            auto resizes = screen::resizes().load();
+            if (resizes != this->resizes_) {
+                this->resizes_ = resizes;
+                event = Event(Event::Kind::Resize);
+                return true;
+            }
+#endif
+            if (this->woken_.exchange(false)) {
+                event = Event(Event::Kind::Wake);
+                return true;
+            }
+            return this->due_timer(event, now);
+        }
+
+        // the earliest of `deadline` and the timers
+        clock::time_point next_deadline(clock::time_point deadline) const {
+            for (const auto& timer : this->timers_) {
+                if (timer.next < deadline) {
+                    deadline = timer.next;
+                }
+            }
+#ifndef _WIN32
+            if (this->reader_.pending() && this->partial_until_ < deadline) {
+                deadline = this->partial_until_;
+            }
+#endif
+            return deadline;
+        }
+
+        // milliseconds until `deadline`, rounded up so we don't wake too early, -1 for never
+        static int ms_until(clock::time_point deadline, clock::time_point now) {
+            if (deadline == clock::time_point::max()) {
+                return -1;
+            }
+            if (deadline <= now) {
+                return 0;
+            }
+            auto left = deadline - now + std::chrono::microseconds(999);
+            return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(left).count());
+        }
+
+      public:
+#ifdef _WIN32
+        EventLoop() : wake_event_(CreateEvent(nullptr, FALSE, FALSE, nullptr)) {
+            if (this->wake_event_ == nullptr) {
+                std::cerr << "couldn't create the event loop's wake event\n";
+                exit(1);
+            }
+        }
+        ~EventLoop() { CloseHandle(this->wake_event_); }
+#else
+        explicit EventLoop(int input_fd = STDIN_FILENO) : input_fd_(input_fd), reader_(input_fd) {
+            if (::pipe(this->pipe_) == -1) {
+                err(1, "couldn't create the event loop's pipe");
+            }
+            for (auto fd : this->pipe_) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+            // makes sure the SIGWINCH handler is installed
+            screen::size_cache();
+            this->resizes_ = screen::resizes().load();
+            screen::resize_notify_fd().store(this->pipe_[1]);
+        }
+        ~EventLoop() {
+            auto fd = this->pipe_[1];
+            screen::resize_notify_fd().compare_exchange_strong(fd, -1);
+            close(this->pipe_[0]);
+            close(this->pipe_[1]);
+        }
+#endif
+        EventLoop(const EventLoop&) = delete;
+        EventLoop& operator=(const EventLoop&) = delete;
+
+        // call `fd` ready (`Event::Kind::Fd`) when it can be read from
+        void watch(int fd) {
+#ifndef _WIN32
+            this->fds_.push_back(fd);
+#endif
+            (void)fd;
+        }
+        void unwatch(int fd) {
+#ifndef _WIN32
+            for (auto it = this->fds_.begin(); it != this->fds_.end(); ++it) {
+                if (*it == fd) {
+                    this->fds_.erase(it);
+                    break;
+                }
+            }
+#endif
+            (void)fd;
+        }
+
+        // an `Event::Kind::Timer` every `interval_ms`, or just once if not `repeat`
+        // returns: the id of the timer, found in `Event::timer`
+        unsigned add_timer(unsigned interval_ms, bool repeat = true) {
+            auto interval = std::chrono::duration_cast<clock::duration>(std::chrono::milliseconds(interval_ms));
+            this->timers_.push_back(Timer{++this->last_timer_, clock::now() + interval, interval, repeat});
+            return this->last_timer_;
+        }
+        void cancel_timer(unsigned id) {
+            for (auto it = this->timers_.begin(); it != this->timers_.end(); ++it) {
+                if (it->id == id) {
+                    this->timers_.erase(it);
+                    break;
+                }
+            }
+        }
+
+        // merge bursts of mouse motion and wheel reports into one `Event`, see `InputReader::coalesce()`
+        void coalesce(bool enable) {
+#ifndef _WIN32
+            this->reader_.coalesce(enable);
+#endif
+            (void)enable;
+        }
+
+        // make `wait_event()` return `Event::Kind::Wake`, can be called from any thread
+        void wake() {
+            this->woken_.store(true);
+#ifdef _WIN32
+            SetEvent(this->wake_event_);
+#else
+            const char byte = 0;
+            if (::write(this->pipe_[1], &byte, 1) < 0) {
+                // full, there's a wake up waiting anyway
+            }
+#endif
+        }
+
+        // wait at most `timeout_ms` (forever if negative) for the next event
+        // returns: the event, `Event::Kind::None` if nothing happened in time
+        Event wait_event(int timeout_ms = -1) {
+            auto now = clock::now();
+            auto deadline = timeout_ms < 0 ? clock::time_point::max() : now + std::chrono::milliseconds(timeout_ms);
+            Event event;
+            while (!this->pending(event, now)) {
+                if (now >= deadline) {
+                    return Event();
+                }
+                auto wait = EventLoop::ms_until(this->next_deadline(deadline), now);
+#ifdef _WIN32
+                HANDLE in = GetStdHandle(STD_INPUT_HANDLE);
+                // a wake up only needs the loop to go round, it's counted in `woken_`
+                HANDLE handles[2] = {in, this->wake_event_};
+                auto ready = WaitForMultipleObjects(2, handles, FALSE, wait < 0 ? INFINITE : static_cast<DWORD>(wait));
+                if (ready == WAIT_OBJECT_0) {
+                    // drop everything `_getch()` wouldn't return
+                    bool resized = false;
+                    INPUT_RECORD record;
+                    DWORD n = 0;
+                    while (PeekConsoleInput(in, &record, 1, &n) != 0 && n == 1) {
+                        if (record.EventType == KEY_EVENT && record.Event.KeyEvent.bKeyDown != 0 && _kbhit() != 0) {
+                            break;
+                        }
+                        ReadConsoleInput(in, &record, 1, &n);
+                        resized = resized || record.EventType == WINDOW_BUFFER_SIZE_EVENT;
+                    }
+                    if (resized) {
+                        return Event(Event::Kind::Resize);
+                    }
+                    if (_kbhit() != 0) {
+                        return Event(::Input::read());
+                    }
+                }
+#else
+                this->pfds_.clear();
+                this->pfds_.push_back({this->pipe_[0], POLLIN, 0});
+                this->pfds_.push_back({this->input_fd_, POLLIN, 0});
+                for (auto fd : this->fds_) {
+                    this->pfds_.push_back({fd, POLLIN, 0});
+                }
+                auto ready = ::poll(this->pfds_.data(), this->pfds_.size(), wait);
+                if (ready < 0 && errno != EINTR) {
+                    err(1, "poll");
+                }
+                if (ready > 0) {
+                    // resizes and wake ups are counted elsewhere, the bytes only woke us up
+                    if ((this->pfds_[0].revents & POLLIN) != 0) {
+                        char drain[64];
+                        while (::read(this->pipe_[0], drain, sizeof(drain)) > 0) {
+                        }
+                    }
+                    if (this->pfds_[1].revents != 0) {
+                        if (this->reader_.fill() <= 0 && !this->reader_.pending()) {
+                            // end of input
+                            return Event(::Input(SpecKey::None));
+                        }
+                        auto esc_timeout = std::chrono::milliseconds(int{InputReader::ESC_TIMEOUT_MS});
+                        this->partial_until_ = clock::now() + esc_timeout;
+                    }
+                    for (size_t i = 2; i < this->pfds_.size(); ++i) {
+                        if (this->pfds_[i].revents != 0) {
+                            event = Event(Event::Kind::Fd);
+                            event.fd = this->pfds_[i].fd;
+                            event.revents = this->pfds_[i].revents;
+                            return event;
+                        }
+                    }
+                }
+#endif
+                now = clock::now();
+            }
+            return event;
+        }
+    };
+} // namespace tui
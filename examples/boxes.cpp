@@ -1,76 +1,61 @@
 #include "../coords.hpp"
+#include "../draw.hpp"
+#include "../frame.hpp"
 #include "../input.hpp"
+#include "../queue.hpp"
+#include "../scheduler.hpp"
 #include "../tui.hpp"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstdint>
+#include <iostream>
 #include <thread>
 #include <vector>
 
 using Box = std::pair<Coord, Coord>;
 
 struct AppState {
-    Input input;
-    bool quit = false;
-    bool new_input = true;
+    // keys read on the reader thread, with a wakeup so the render thread can sleep while there are none
+    tui::SpscQueue<Input> inputs{true};
+    std::atomic<bool> quit{false};
+    tui::FrameScheduler sched{tui::FrameScheduler::clock::duration::zero(), 120};
     Coord size = Coord::screen_size();
 } state;
 
 // make `x` be good for `counter_box`
-std::string count(const uint64_t& x) {
-    // unsigned r = 0;
-    std::string print;
+tui::Cell count(const uint64_t& x) {
     if (x % 100 == 0) {
-        print = std::to_string(x / 100);
-        print = tui::string(print[0]).on_red().black();
-    } else if (x % 10 == 0) {
-        print = std::to_string(x / 10 % 10);
-        print = tui::string(print[0]).on_blue().black();
-    } else {
-        print = std::to_string(x);
-        print = print.back();
+        return {std::to_string(x / 100).substr(0, 1), tui::Style().on_red().black()};
+    }
+    if (x % 10 == 0) {
+        return {std::to_string(x / 10 % 10), tui::Style().on_blue().black()};
     }
-    return print;
+    return {std::to_string(x % 10)};
 }
 
-void counter_box(Coord start, Coord end) {
+void counter_box(tui::Frame& frame, Coord start, Coord end) {
     assert(start.row <= end.row && start.col <= end.col);
 
     // do rows
     // from top to down
     for (auto row = start.row + 1; row < end.row; ++row) {
         // left row
-        start.with_row(row).print(count(row));
+        frame.set(start.with_row(row), count(row));
         // right row
-        end.with_row(row).print(count(row));
+        frame.set(end.with_row(row), count(row));
     }
 
     // do columns
-    // top left
-    start.set_cursor();
     for (auto col = start.col; col <= end.col; ++col) {
-        std::cout << count(col);
-    }
-    // bottom left
-    end.with_col(start.col).set_cursor();
-    for (auto col = start.col; col <= end.col; ++col) {
-        std::cout << count(col);
+        // top
+        frame.set(start.with_col(col), count(col));
+        // bottom
+        frame.set(end.with_col(col), count(col));
     }
 }
 
-enum class Kind : std::uint8_t {
-    Empty = 0,
-    Basic = 1,
-    Bold = 2,
-    Rounded = 3,
-};
-
-const std::vector<std::vector<std::string>> KINDS = {{{" ", " ", " ", " ", " ", " "}},
-                                                     {{"┌", "┐", "└", "┘", "│", "─"}},
-                                                     {{"┏", "┓", "┗", "┛", "┃", "━"}},
-                                                     {{"╭", "╮", "╰", "╯", "│", "─"}}};
-
 // start.row ------------ start.col
 // |                              |
 // |                              |
@@ -80,81 +65,81 @@ const std::vector<std::vector<std::string>> KINDS = {{{" ", " ", " ", " ", " ",
 // |                              |
 // |                              |
 // end.row ---------------- end.col
-void draw_box(Box box, Kind with) {
+void draw_box(tui::Frame& frame, Box box, tui::draw::Border with, const tui::Style& style = tui::Style()) {
     auto start = box.first;
     auto end = box.second;
     assert(start.row <= end.row && start.col <= end.col);
 
-    const auto& draw = KINDS.at(static_cast<size_t>(with));
+    const auto& draw = tui::draw::glyphs(with);
 
     // do rows
     for (auto row = start.row + 1; row < end.row; ++row) {
         // left row
-        start.with_row(row).print(draw[4]);
+        frame.set(start.with_row(row), {draw.vertical, style});
         // right row
-        end.with_row(row).print(draw[4]);
+        frame.set(end.with_row(row), {draw.vertical, style});
     }
 
     // do columns
-    // top left
-    start.print(draw[0]);
-    for (auto i = start.col + 1; i < end.col; ++i) {
-        std::cout << draw[5];
-    }
-    // top right
-    std::cout << draw[1];
-    // bottom left
-    end.with_col(start.col).print(draw[2]);
-    for (auto i = start.col + 1; i < end.col; ++i) {
-        std::cout << draw[5];
+    for (auto col = start.col + 1; col < end.col; ++col) {
+        frame.set(start.with_col(col), {draw.horizontal, style});
+        frame.set(end.with_col(col), {draw.horizontal, style});
     }
-    // bottom right
-    std::cout << draw[3];
+    frame.set(start, {draw.top_left, style});
+    frame.set(start.with_col(end.col), {draw.top_right, style});
+    frame.set(end.with_col(start.col), {draw.bottom_left, style});
+    frame.set(end, {draw.bottom_right, style});
 }
 
-void handle_keys(std::vector<Box>& boxes, unsigned& cnt_box_ix) {
+Rect to_rect(const Box& box) { return Rect{box.first, box.second}; }
+
+// only the current box changes, either its place, its size or its style, so it's the only one to be redrawn
+void handle_keys(tui::Frame& frame, const Input& input, std::vector<Box>& boxes, unsigned& cnt_box_ix) {
+    if (boxes.empty()) {
+        return;
+    }
     auto* cnt_box = &boxes[cnt_box_ix];
-    if (state.input == 'n' || state.input == SpecKey::Tab) {
+    frame.damage(to_rect(*cnt_box));
+    if (input == 'n' || input == SpecKey::Tab) {
         if (cnt_box_ix++ == boxes.size() - 1) {
             cnt_box_ix = 0;
         }
-    } else if (state.input == 'p' /* || state.input == SpecKey::ShiftTab */) {
+    } else if (input == 'p' /* || input == SpecKey::ShiftTab */) {
         if (cnt_box_ix-- == 0) {
             cnt_box_ix = static_cast<int>(boxes.size()) - 1;
         }
-    } else if (state.input == 'j' || state.input == Arrow::Down) {
-        draw_box(*cnt_box, Kind::Empty);
+    } else if (input == 'j' || input == Arrow::Down) {
         cnt_box->first.row++;
         cnt_box->second.row++;
-    } else if (state.input == 'k' || state.input == Arrow::Up) {
-        draw_box(*cnt_box, Kind::Empty);
+    } else if (input == 'k' || input == Arrow::Up) {
         cnt_box->first.row--;
         cnt_box->second.row--;
-    } else if (state.input == 'h' || state.input == Arrow::Left) {
-        draw_box(*cnt_box, Kind::Empty);
+    } else if (input == 'h' || input == Arrow::Left) {
         cnt_box->first.col--;
         cnt_box->second.col--;
-    } else if (state.input == 'l' || state.input == Arrow::Right) {
-        draw_box(*cnt_box, Kind::Empty);
+    } else if (input == 'l' || input == Arrow::Right) {
         cnt_box->first.col++;
         cnt_box->second.col++;
-    } else if (state.input == '-') {
-        draw_box(*cnt_box, Kind::Empty);
+    } else if (input == '-') {
         cnt_box->first.row++;
         cnt_box->first.col++;
 
         cnt_box->second.row--;
         cnt_box->second.col--;
-    } else if (state.input == '+') {
-        draw_box(*cnt_box, Kind::Empty);
+    } else if (input == '+') {
         cnt_box->first.row--;
         cnt_box->first.col--;
 
         cnt_box->second.row++;
         cnt_box->second.col++;
-    } else if (state.input == 'd' || state.input == SpecKey::Backspace) {
-        draw_box(*cnt_box, Kind::Empty);
+    } else if (input == 'd' || input == SpecKey::Backspace) {
         boxes.erase(boxes.begin() + cnt_box_ix);
+        if (cnt_box_ix == boxes.size()) {
+            cnt_box_ix = 0;
+        }
+    }
+    if (!boxes.empty()) {
+        frame.damage(to_rect(boxes[cnt_box_ix]));
     }
 }
 void run() {
@@ -174,59 +159,87 @@ void run() {
     };
 
     unsigned cnt_box_ix = 0;
-    Coord prev_size;
+    tui::Frame frame(state.size);
+    // only diff what a keypress changed
+    frame.track_damage(true);
+    frame.damage(frame.area());
 
+    // no ticks, only redraws on input, 120fps at most
     do {
         state.size = Coord::screen_size();
-        if (prev_size != state.size) {
-            prev_size = state.size;
-            tui::screen::clear();
-        } else if (!state.new_input) {
-            continue; // if there's no new input, don't draw anything
+        if (frame.size() != state.size) {
+            frame.resize(state.size);
+            tui::output().set_width(state.size.col);
+            frame.damage(frame.area());
+            state.sched.mark_dirty();
+        }
+        // everything typed since the last frame
+        if (state.inputs.drain([&](const Input& input) {
+                if (input == 'q' || input == SpecKey::CtrlC) {
+                    state.quit = true;
+                }
+                handle_keys(frame, input, boxes, cnt_box_ix);
+            }) != 0) {
+            state.sched.mark_dirty();
+        }
+        if (!state.sched.begin_frame()) {
+            // nothing new or too early: sleep until either a key or the next frame, check for a resize now and then
+            state.inputs.wait(state.sched.timeout_ms(100));
+            continue;
         }
-        counter_box({1, 1}, state.size);
-        handle_keys(boxes, cnt_box_ix);
         auto msg_start = msg_coord(true);
         auto msg_end = msg_coord(false);
         Box msg_box = {{msg_start.row - 1, msg_start.col - 1}, {msg_end.row + 1, msg_end.col}};
         if (!std::any_of(boxes.begin(), boxes.end(), [msg_box](Box item) { return item == msg_box; })) {
             boxes.push_back(msg_box);
+            frame.damage(to_rect(msg_box));
         }
 
-        for (auto box : boxes) {
-            if (box == boxes[cnt_box_ix]) {
-                std::cout << tui::text::color::cyan_fg();
-                draw_box(box, Kind::Rounded);
-                std::cout << tui::text::style::reset_style();
-            } else {
-                draw_box(box, Kind::Basic);
+        // draw only what's in the damaged areas, in the same order as for a whole frame
+        frame.redraw([&](const Rect& area) {
+            if (area.start.row == 1 || area.start.col == 1 || area.end.row == state.size.row ||
+                area.end.col == state.size.col) {
+                counter_box(frame, {1, 1}, state.size);
+            }
+            for (const auto& box : boxes) {
+                if (!to_rect(box).intersects(area)) {
+                    continue;
+                }
+                if (box == boxes[cnt_box_ix]) {
+                    draw_box(frame, box, tui::draw::Border::Rounded, tui::Style().cyan());
+                } else {
+                    draw_box(frame, box, tui::draw::Border::Basic);
+                }
             }
-        }
 
-        msg_start.print(msg.bold().italic().inverted().blue());
+            frame.print(msg_start, msg, tui::Style().bold().italic().inverted().blue());
 
-        Coord(state.size.row / 3 * 2, state.size.col / 3 * 2)
-            .print(tui::string("tui.hpp").blue().link("https://github.com/csboo/cpptui").on_magenta());
+            frame.print(Coord(state.size.row / 3 * 2, state.size.col / 3 * 2), "tui.hpp",
+                        tui::Style().blue().on_magenta(), "https://github.com/csboo/cpptui");
+        });
 
-        state.new_input = false;
+        frame.present();
 
         std::cout.flush();
-        // 120fps
-        std::this_thread::sleep_for(std::chrono::milliseconds(8));
+        state.sched.end_frame();
     } while (!state.quit);
 }
 
 void handle_read() {
-    while (state.input != 'q' && state.input != SpecKey::CtrlC) {
-        state.input = Input::read();
-        state.new_input = true;
-        std::this_thread::sleep_for(std::chrono::milliseconds(8));
+    Input input;
+    while (input != 'q' && input != SpecKey::CtrlC) {
+        input = Input::read();
+        state.inputs.push(input);
     }
-    state.quit = true;
 }
 
 int main() {
     tui::init();
+    // collect each frame, write it with a single syscall on `flush()`
+    tui::output().attach();
+    // before the reader thread starts, as the answer comes on the input
+    // and have the terminal paint it at once, if it can
+    tui::output().synchronized(tui::supports_synchronized_output());
 
     std::thread reader(handle_read);
 
@@ -236,5 +249,11 @@ int main() {
 
     tui::reset();
 
+    const auto& stats = state.sched.stats();
+    std::cout << stats.frames << " frames, "
+              << std::chrono::duration_cast<std::chrono::microseconds>(stats.avg_frame_time()).count()
+              << "us on average, "
+              << std::chrono::duration_cast<std::chrono::microseconds>(stats.max_frame_time).count() << "us at most\n";
+
     return 0;
 }
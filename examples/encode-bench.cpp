@@ -0,0 +1,78 @@
+#include "../tui.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// compares the `tui::concat` (`std::ostringstream`) path with the allocation-free `tui::encode` one
+// usage: encode-bench [iterations]
+
+// keep the compiler from optimizing the work away
+static uint64_t checksum = 0;
+static volatile char last_byte = 0;
+
+// returns how long `n` calls of `fn` took in ns
+template <typename Fn> uint64_t time_n(const unsigned n, Fn fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < n; ++i) {
+        fn(i);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+void report(const char* what, const unsigned n, const uint64_t concat_ns, const uint64_t encode_ns) {
+    std::cout << what << ":\n"
+              << "\tconcat: " << concat_ns / n << "ns/op\n"
+              << "\tencode: " << encode_ns / n << "ns/op\n"
+              << "\tspeedup: " << static_cast<double>(concat_ns) / static_cast<double>(encode_ns) << "x\n";
+}
+
+int main(int argc, char** argv) {
+    unsigned n = 1000000;
+    if (argc > 1) {
+        n = std::stoi(argv[1]);
+    }
+
+    // CSI row;col H
+    auto concat_ns = time_n(n, [](unsigned i) {
+        auto seq = tui::concat(tui::CSI, i % 300, ';', i % 80, 'H');
+        checksum += seq.size();
+    });
+    auto encode_ns = time_n(n, [](unsigned i) {
+        char buf[tui::encode::MAX_SEQ];
+        auto* end = tui::encode::cursor_position(buf, i % 300, i % 80);
+        last_byte = buf[2];
+        checksum += end - buf;
+    });
+    report("set_position", n, concat_ns, encode_ns);
+
+    // CSI 38;2;r;g;b m
+    concat_ns = time_n(n, [](unsigned i) {
+        auto seq = tui::concat(tui::CSI, '3', "8;2;", i % 256, ';', (i >> 8U) % 256, ';', (i >> 16U) % 256, 'm');
+        checksum += seq.size();
+    });
+    encode_ns = time_n(n, [](unsigned i) {
+        char buf[tui::encode::MAX_SEQ];
+        auto* end = tui::encode::rgb(buf, i % 256, (i >> 8U) % 256, (i >> 16U) % 256, true);
+        last_byte = buf[7];
+        checksum += end - buf;
+    });
+    report("rgb", n, concat_ns, encode_ns);
+
+    // CSI n m
+    concat_ns = time_n(n, [](unsigned i) {
+        auto seq = tui::concat(tui::CSI, i % 10, 'm');
+        checksum += seq.size();
+    });
+    encode_ns = time_n(n, [](unsigned i) {
+        char buf[tui::encode::MAX_SEQ];
+        auto* end = tui::encode::sgr(buf, i % 10);
+        last_byte = buf[2];
+        checksum += end - buf;
+    });
+    report("style", n, concat_ns, encode_ns);
+
+    std::cout << "(checksum: " << checksum << ")\n";
+    return 0;
+}
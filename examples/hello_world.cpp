@@ -11,13 +11,13 @@ int main() {
 
     Input input;                                      // this will handle special stuff like arrows, ctrl+c, ...
     while (input != SpecKey::CtrlC && input != 'q') { // main loop
-        // NOTE: use `.size()` before styling, as it'd be completely crazy after applying styles
+        // NOTE: `.display_width()` counts the cells taken on screen, `.size()` is the bytes including the styling
         // `msg` will be in the middle of the screen
-        tui::cursor::set_position((screen_size.first / 2) - 1, (screen_size.second / 2) - (msg.size() / 2));
+        tui::cursor::set_position((screen_size.first / 2) - 1, (screen_size.second / 2) - (msg.display_width() / 2));
         std::cout << msg.blue().link("https://github.com/csboo/cpptui").bold().underline();
 
         // `msg` will be in the middle of the screen
-        tui::cursor::set_position((screen_size.first / 2) + 1, (screen_size.second / 2) - (note.size() / 2));
+        tui::cursor::set_position((screen_size.first / 2) + 1, (screen_size.second / 2) - (note.display_width() / 2));
         std::cout << note.on_rgb(106, 150, 137).rgb(148, 105, 117).italic().dim();
 
         std::cout.flush();
@@ -0,0 +1,93 @@
+#include "../input.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+// how fast `InputParser` decodes raw input, fed in `read()`-sized chunks so sequences get split between them,
+// and how fast `InputReader` does the same, reading it from a file
+// usage: input-bench [megabytes]
+
+// keep the compiler from optimizing the work away
+static uint64_t checksum = 0;
+
+// `text` repeated until it's at least `size` bytes
+std::string repeat(const std::string& text, const size_t size) {
+    std::string out;
+    out.reserve(size + text.size());
+    while (out.size() < size) {
+        out += text;
+    }
+    return out;
+}
+
+void report(const char* what, const size_t size, const uint64_t events,
+            const std::chrono::high_resolution_clock::duration took) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(took).count();
+    auto mb = static_cast<double>(size) / (1024.0 * 1024.0);
+    std::cout << what << ":\n"
+              << "\t" << mb / (static_cast<double>(ns) / 1e9) << " MB/s\n"
+              << "\t" << static_cast<double>(ns) / static_cast<double>(events) << " ns/input\n";
+}
+
+void bench(const char* what, const std::string& input) {
+    const size_t CHUNK = 4096;
+    InputParser parser;
+    Input out;
+    uint64_t events = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < input.size(); i += CHUNK) {
+        const char* data = input.data() + i;
+        const char* end = input.data() + std::min(input.size(), i + CHUNK);
+        while (parser.feed(data, end, out)) {
+            ++events;
+            checksum += out.mods + out.codepoint;
+        }
+    }
+    report(what, input.size(), events, std::chrono::high_resolution_clock::now() - start);
+}
+
+#ifndef _WIN32
+// through `InputReader`, which decodes runs of printable ascii without the parser
+void bench_reader(const char* what, const std::string& input) {
+    auto* file = std::tmpfile();
+    std::fwrite(input.data(), 1, input.size(), file);
+    std::fflush(file);
+    std::rewind(file);
+    InputReader reader(fileno(file));
+    uint64_t events = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Input out;
+    do {
+        while (reader.next(out)) {
+            ++events;
+            checksum += out.mods + out.codepoint;
+        }
+    } while (reader.fill() > 0);
+    report(what, input.size(), events, std::chrono::high_resolution_clock::now() - start);
+    std::fclose(file);
+}
+#endif
+
+int main(int argc, char** argv) {
+    size_t size = 64;
+    if (argc > 1) {
+        size = std::stoi(argv[1]);
+    }
+    size *= 1024 * 1024;
+
+    const auto typing = repeat("the quick brown fox jumps over the lazy dog\r", size);
+    bench("typing", typing);
+#ifndef _WIN32
+    bench_reader("typing (reader)", typing);
+#endif
+    bench("utf-8", repeat("árvíztűrő tükörfúrógép, \xE2\x82\xAC \xF0\x9F\x98\x80\r", size));
+    bench("keys", repeat("\x1b[A\x1b[1;5B\x1bOP\x1b[15~\x1b[24;2~\x1b[3~\x1bx\x1b[Z", size));
+    bench("mixed", repeat("ls -la\x1b[D\x1b[D\x7f\x1b]11;rgb:0000/0000/0000\x1b\\\x01\x1b[1;3C\r", size));
+
+    std::cout << "(checksum: " << checksum << ")\n";
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "../event_loop.hpp"
+#include "../frame.hpp"
+#include "../terminfo.hpp"
+#include "../tui.hpp"
+#include <deque>
+#include <string>
+
+// a scrolling log, like `tail -f`: every new line moves the rest up, which the `Frame` scrolls on the terminal
+// instead of writing every row again, see the bytes per frame at the bottom
+// usage: log-tail, q or Ctrl+C to quit, space to pause
+
+int main() {
+    tui::init();
+    tui::output().attach();
+    // run compression, synchronized updates and colors, as far as the terminal has them
+    tui::apply_terminfo();
+
+    tui::Frame frame;
+    // moving the rows needs a scroll region, assume it has one if there's no entry
+    const auto& info = tui::terminfo();
+    frame.detect_scroll(!info.found() || info.has(tui::Terminfo::String::change_scroll_region));
+    std::deque<std::string> lines;
+    unsigned count = 0;
+    bool paused = false;
+
+    tui::EventLoop loop;
+    loop.add_timer(50);
+    while (true) {
+        auto event = loop.wait_event();
+        if (event.kind == tui::Event::Kind::Input) {
+            if (event.input == 'q' || event.input == SpecKey::CtrlC) {
+                break;
+            }
+            if (event.input == ' ') {
+                paused = !paused;
+            }
+            continue;
+        }
+        if (event.kind == tui::Event::Kind::Resize) {
+            tui::screen::clear();
+            frame.resize(Coord::screen_size());
+            tui::output().set_width(frame.size().col);
+        } else if (paused) {
+            continue;
+        } else {
+            ++count;
+            lines.push_back("[" + std::to_string(count) + "] GET /api/items/" + std::to_string(count * 7919 % 1000) +
+                            " 200 " + std::to_string(count % 37) + "ms");
+        }
+
+        // the last row is the status line
+        auto rows = frame.size().row - 1;
+        while (lines.size() > rows) {
+            lines.pop_front();
+        }
+        frame.clear();
+        for (unsigned row = 0; row < lines.size(); ++row) {
+            auto style = (lines[row].find(" 200 3") != std::string::npos) ? tui::Style().yellow() : tui::Style();
+            frame.print({row + 1, 1}, lines[row], style);
+        }
+        frame.print({frame.size().row, 1}, "last frame: " + std::to_string(tui::output().stats().bytes) + " bytes",
+                    tui::Style().inverted());
+        frame.present();
+        std::cout.flush();
+    }
+
+    tui::reset();
+    return 0;
+}
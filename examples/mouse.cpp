@@ -0,0 +1,33 @@
+#include "../event_loop.hpp"
+#include "../input.hpp"
+#include "../tui.hpp"
+
+// NOTE: doesn't work on windows
+int main() {
+    tui::init();
+    tui::mouse::enable(tui::mouse::Tracking::Motion); // every motion, not just drags
+    tui::EventLoop loop;
+
+    std::cout << "move, click and scroll around, 'q' to quit\r\n";
+    Input input;
+    unsigned events = 0;
+    while (input != 'q' && input != SpecKey::CtrlC) {
+        auto event = loop.wait_event();
+        if (event.kind != tui::Event::Kind::Input) {
+            continue;
+        }
+        input = event.input;
+        if (!input.is_mouse) {
+            continue;
+        }
+        // motions and wheel notches arriving together are merged, `count` tells how many of them
+        events += input.mouse.count;
+        tui::cursor::home();
+        tui::screen::clear_line();
+        std::cout << input << "\t(reports: " << events << ")";
+        std::cout.flush();
+    }
+
+    tui::reset();
+    return 0;
+}
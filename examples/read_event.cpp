@@ -1,43 +1,34 @@
 #include "../input.hpp"
+#include "../queue.hpp"
 #include "../tui.hpp"
 #include <chrono>
-#include <condition_variable>
 #include <iostream>
-#include <mutex>
 #include <thread>
 
-static std::mutex mtx;
-static std::condition_variable cv;
-static Input shared_input;
-static bool input_available = false;
+// filled by the reader thread, emptied by the main one, no locks needed
+static tui::SpscQueue<Input> inputs;
 
 bool should_quit(const Input& input) { return input == SpecKey::CtrlC || input == 'q'; }
 
 void read_input() {
-    while (!should_quit(shared_input)) {
-        shared_input = Input::read();
-        std::lock_guard<std::mutex> lock(mtx);
-        input_available = true;
-        cv.notify_one();
-        std::this_thread::sleep_for(std::chrono::milliseconds(8));
+    Input input;
+    while (!should_quit(input)) {
+        input = Input::read();
+        inputs.push(input);
     }
 }
 
 void main_task() {
     int i = 0;
-    while (true) {
+    bool quit = false;
+    while (!quit) {
         std::this_thread::sleep_for(std::chrono::milliseconds(40));
 
-        {
-            std::lock_guard<std::mutex> lock(mtx);
-            if (input_available) {
-                std::cout << "Character read from input: " << shared_input << "\r\n";
-                if (should_quit(shared_input)) {
-                    return;
-                }
-                input_available = false;
-            }
-        }
+        // everything that arrived during the sleep, none are lost
+        inputs.drain([&](const Input& input) {
+            std::cout << "Character read from input: " << input << "\r\n";
+            quit |= should_quit(input);
+        });
 
         std::cout << i << "\r\n";
         ++i;
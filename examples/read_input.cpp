@@ -1,8 +1,9 @@
-#include "../tui.hpp"
+#include "../event_loop.hpp"
 #include "../input.hpp"
+#include "../tui.hpp"
 
-// get's called on terminall resize
-void clear(int /*sig*/) {
+// get's called after the terminal was resized
+void clear() {
     tui::screen::clear(); // clears screen
     tui::cursor::home();  // sets the cursor to the top left corner of the screen
     // no need to flush `cout`, as `'\n'` does it (well, yeah. don't ask me why though)
@@ -11,14 +12,24 @@ void clear(int /*sig*/) {
 
 int main() {
     tui::init();
-    // NOTE: doesn't work on windows
-    // on terminal resize, we use our `clear()` function
-    tui::set_up_resize(clear);
+    // a paste arrives as a single input, instead of thousands of characters
+    tui::bracketed_paste(true);
+    // waits for both input and resizes, without any threads
+    tui::EventLoop loop;
 
     try {
         Input input;
         do {
-            input = Input::read();                        // convert it into an `Input`
+            auto event = loop.wait_event(); // blocks until something happens
+            if (event.kind == tui::Event::Kind::Resize) {
+                clear(); // on terminal resize, we use our `clear()` function
+                continue;
+            }
+            input = event.input;
+            if (input == SpecKey::CtrlZ) {
+                tui::suspend(); // back to the shell, until `fg`
+                continue;
+            }
             std::cout << "-\tinput: " << input << "\r\n"; // see how easy it is to print an `Input`
         } while (input != SpecKey::CtrlC);
     } catch (...) { // NOTE: probably won't happen, but it's good to be careful
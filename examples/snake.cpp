@@ -1,7 +1,10 @@
 #include "../coords.hpp"
 #include "../input.hpp"
+#include "../queue.hpp"
+#include "../scheduler.hpp"
 #include "../tui.hpp"
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
@@ -152,8 +155,8 @@ struct App {
     Snake snake = App::default_snake();
     Coord apple = Coord::random(this->screen_size);
     Dir dir = Dir::Right;
-    Input input;
-    bool quit = false;
+    // set by either thread
+    std::atomic<bool> quit{false};
 
     static Snake default_snake() {
         auto mid = Coord::screen_size() / 2;
@@ -269,61 +272,95 @@ struct App {
 
 } app;
 
+// keys read on the reader thread, waiting for the next tick of the render thread
+tui::SpscQueue<Input> inputs;
+
+bool is_quit(const Input& input) {
+    return input == 'q' || input == 'Q' || input == SpecKey::CtrlC || input == SpecKey::CtrlD ||
+           input == SpecKey::CtrlZ;
+}
+
 void handle_read() {
-    while (!app.quit && app.input != 'q' && app.input != 'Q' && app.input != SpecKey::CtrlC &&
-           app.input != SpecKey::CtrlD && app.input != SpecKey::CtrlZ) {
-        app.input = Input::read();
-        std::this_thread::sleep_for(std::chrono::milliseconds(8));
+    Input input;
+    while (!app.quit && !is_quit(input)) {
+        input = Input::read();
+        // full only if the render thread is stuck, dropping keys is fine then
+        inputs.push(input);
     }
-    app.quit = true;
-    std::cout << "reader thread done\n";
+    // `std::cout` belongs to the render thread
+    std::cerr << "reader thread done\n";
 }
 
-void run() {
-    app.apple.print(APPLE_TEXT);
-    do {
-        // get direction
-        auto prev_dir = app.dir;
-        app.dir = from_input(app.input, prev_dir);
+// the snake gets slower as it grows, and when moving vertically, as the cells are taller than wide
+std::chrono::milliseconds tick_duration() {
+    auto mul = (app.dir == Dir::Left || app.dir == Dir::Right) ? 1 : 2;
+    return (SLEEP_MS + (-(ADD_MS * 10) + ADD_MS * static_cast<unsigned>(app.snake.size()))) * mul;
+}
+
+// move the snake by one
+void tick() {
+    // get direction: one turn per tick, so quick turns in a row aren't lost, nor make the snake reverse
+    auto prev_dir = app.dir;
+    Input input;
+    while (app.dir == prev_dir && inputs.pop(input)) {
+        if (is_quit(input)) {
+            app.quit = true;
+            return;
+        }
+        app.dir = from_input(input, prev_dir);
         if (prev_dir == opposite(app.dir)) {
             app.dir = prev_dir;
         }
+    }
 
-        // and move snake correspondly
-        app.move_snake();
+    // and move snake correspondly
+    app.move_snake();
 
-        // die if wanna eat itself
-        if (app.snake_contains(app.snake.front(), 1)) {
-            app.quit = true;
-            return;
-        }
+    // die if wanna eat itself
+    if (app.snake_contains(app.snake.front(), 1)) {
+        app.quit = true;
+        return;
+    }
 
-        // snake ate apple, we need a new one!
-        if (app.snake.front() == app.apple) {
-            app.eat_apple();
-        }
+    // snake ate apple, we need a new one!
+    if (app.snake.front() == app.apple) {
+        app.eat_apple();
+    }
 
-        std::cout << tui::text::color::blue_fg();
-        // print non-head parts of snake, but only first 2
-        for (auto i = 1; i < ((app.snake.size() == 1) ? 1 : 2); ++i) {
-            auto nb = app.neighbours(i);
-            app.snake[i].print(draw(nb));
+    // written only if the score or the apple changed the style since the last tick
+    tui::output().style(tui::Style().blue());
+    // print non-head parts of snake, but only first 2
+    for (auto i = 1; i < ((app.snake.size() == 1) ? 1 : 2); ++i) {
+        auto nb = app.neighbours(i);
+        app.snake[i].print(draw(nb));
+    }
+    // print head
+    app.snake.front().print(to_string(app.dir));
+}
+
+void run() {
+    app.apple.print(APPLE_TEXT);
+    // the ticks draw as they go, a frame is just flushing them, no need for a cap
+    tui::FrameScheduler sched(tick_duration(), 0);
+    do {
+        // deadlines are absolute, so a late wakeup doesn't delay the following ticks
+        sched.wait();
+        for (auto n = sched.due_ticks(); n > 0 && !app.quit; --n) {
+            tick();
+            sched.set_tick(tick_duration());
+            sched.mark_dirty();
+        }
+        if (sched.begin_frame()) {
+            std::cout.flush();
+            sched.end_frame();
         }
-        // print head
-        app.snake.front().print(to_string(app.dir));
-        std::cout << tui::text::style::reset_style();
-
-        std::cout.flush();
-        auto sleep_mul = (app.dir == Dir::Left || app.dir == Dir::Right) ? 1 : 2;
-        auto sleep_dur = SLEEP_MS + (-(ADD_MS * 10) + ADD_MS * static_cast<unsigned>(app.snake.size()));
-        // sleep, if moving vertically: more
-        std::this_thread::sleep_for(sleep_dur * sleep_mul);
     } while (!app.quit);
 }
 
 int main() {
     try {
         tui::init();
+        tui::output().attach();
 
         std::thread reader(handle_read);
 
@@ -0,0 +1,58 @@
+#include "../terminfo.hpp"
+#include "../tui.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// measures how long setting up and restoring the terminal takes, compared to spawning `stty` like we used to,
+// and how long reading the terminfo entry of `$TERM` takes
+// usage: startup-bench [iterations]
+
+// returns how long `n` calls of `fn` took in ns
+template <typename Fn> uint64_t time_n(const unsigned n, Fn fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < n; ++i) {
+        fn();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+    unsigned n = 20;
+    if (argc > 1) {
+        n = std::stoi(argv[1]);
+    }
+
+    auto raw_ns = time_n(n, []() {
+        tui::enable_raw_mode();
+        tui::disable_raw_mode();
+    });
+    auto init_ns = time_n(n, []() {
+        tui::init();
+        tui::reset();
+        std::cout.flush();
+    });
+    auto terminfo_ns = time_n(n, []() {
+        tui::Terminfo info(std::getenv("TERM"));
+        (void)info;
+    });
+#ifndef _WIN32
+    auto stty_ns = time_n(n, []() {
+        if (std::system("stty raw && stty -echo && stty cooked && stty echo") != 0) {
+            std::cerr << "couldn't run stty\n";
+        }
+    });
+#endif
+
+    std::cout << "raw mode on+off: " << raw_ns / n / 1000 << "us\n";
+    std::cout << "init+reset: " << init_ns / n / 1000 << "us\n";
+    std::cout << "terminfo of $TERM: " << terminfo_ns / n / 1000 << "us"
+              << (tui::terminfo().found() ? "" : " (not found)") << "\n";
+#ifndef _WIN32
+    std::cout << "4x stty (as before): " << stty_ns / n / 1000 << "us\n";
+#endif
+    return 0;
+}
@@ -8,6 +8,8 @@ int main() {
     std::ofstream fout("test.txt");
     fout << "\"" << orig << "\"" << orig.size() << "\n";
     fout << "\"" << styled << "\"" << styled.size() << "\n";
+    // the cells taken on screen, the same for both
+    fout << orig.size() << " == " << styled.display_width() << "\n";
     fout.close();
 
     std::cout << "hello";
@@ -0,0 +1,739 @@
+#pragma once
+
+#include "coords.hpp"
+#include "tui.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// NOTE: typical usage goes:
+// ```c++
+// tui::Frame frame;                                // sized to the screen
+// while (running) {
+//     frame.clear();                               // start from a blank back buffer
+//     frame.print({2, 4}, "score: 42", tui::Style().green());
+//     frame.present();                             // only the changed cells are written
+//     std::cout.flush();
+// }
+// ```
+namespace tui {
+    // one character cell of the screen, what `Frame::set()` takes and `Frame::at()` returns
+    struct Cell {
+        // the utf-8 encoded character displayed in this cell, empty for the right half of a wide one
+        std::string glyph = " ";
+        Style style;
+        // target of the hyperlink this cell is part of, empty if none
+        std::string link;
+
+        Cell() = default;
+        Cell(std::string glyph, const Style& style = Style(), std::string link = "")
+            : glyph(std::move(glyph)), style(style), link(std::move(link)) {}
+
+        bool operator==(const Cell& other) const {
+            return (this->glyph == other.glyph && this->style == other.style && this->link == other.link);
+        }
+        bool operator!=(const Cell& other) const { return !(*this == other); }
+    };
+
+    // double buffered grid of `Cell`s
+    // draw into the back buffer, then `present()` writes only the cells that differ from what's already on screen
+    // INFO: a cell is stored in 8 bytes, the glyph inline (or in a pool if it's more than one code point), the style
+    // and link interned in a table, so both buffers are contiguous, and rows are compared with `memcmp()`
+    class Frame {
+        // how a cell is stored, it only means something with the `Frame`'s tables
+        struct PackedCell {
+            // a glyph of more than one code point (eg. with combining marks), the rest is an index into `pool_`
+            static const uint32_t POOLED = 1U << 31U;
+            // the left half of a character two columns wide, followed by a `CONTINUATION`
+            static const uint8_t WIDE = 1;
+            // the right half, with the same glyph and style as the left one
+            static const uint8_t CONTINUATION = 2;
+
+            // a code point, or `POOLED`
+            uint32_t glyph = ' ';
+            // index into `pens_`
+            uint16_t style = 0;
+            uint8_t flags = 0;
+            // always zero, so there are no padding bytes with garbage for `memcmp()`
+            uint8_t reserved = 0;
+
+            PackedCell() = default;
+            PackedCell(uint32_t glyph, uint16_t style, uint8_t flags = 0) : glyph(glyph), style(style), flags(flags) {}
+
+            bool wide() const { return (this->flags & WIDE) != 0; }
+            bool continuation() const { return (this->flags & CONTINUATION) != 0; }
+
+            bool operator==(const PackedCell& other) const {
+                return (this->glyph == other.glyph && this->style == other.style && this->flags == other.flags);
+            }
+            bool operator!=(const PackedCell& other) const { return !(*this == other); }
+        };
+        static_assert(sizeof(PackedCell) == 8, "`PackedCell` has to stay 8 bytes");
+
+        // a style and the hyperlink (index into `links_`) it's drawn with
+        struct Pen {
+            Style style;
+            uint32_t link = 0;
+            // `style` with the colors fit to `depth_`, what's written, not part of the identity
+            Style written;
+
+            Pen() = default;
+            Pen(const Style& style, uint32_t link) : style(style), link(link), written(style) {}
+
+            bool operator==(const Pen& other) const { return this->style == other.style && this->link == other.link; }
+        };
+        struct PenHash {
+            static uint64_t pack(const Color& color) {
+                return (static_cast<uint64_t>(color.kind) << 32U) | (static_cast<uint64_t>(color.ix) << 24U) |
+                       (static_cast<uint64_t>(color.r) << 16U) | (static_cast<uint64_t>(color.g) << 8U) | color.b;
+            }
+            size_t operator()(const Pen& pen) const {
+                const uint64_t k = 0x9E3779B97F4A7C15ULL;
+                auto hash = (PenHash::pack(pen.style.fg()) * k) ^ PenHash::pack(pen.style.bg());
+                hash = (hash * k) ^ pen.style.attrs() ^ (static_cast<uint64_t>(pen.link) << 16U);
+                hash *= k;
+                return static_cast<size_t>(hash ^ (hash >> 32U));
+            }
+        };
+
+        // the style index is 16 bits
+        static const size_t MAX_PENS = 65536;
+        // `compact_pool()` when it's at least this big
+        static const size_t MIN_POOL_LIMIT = 4096;
+        // glyph of a cell of `front_` whose content on the terminal is unknown, it differs from everything
+        static const uint32_t UNKNOWN = 0xFFFFFFFF;
+
+        Coord size_;
+        // what the terminal is showing
+        std::vector<PackedCell> front_;
+        // what we'd like the terminal to show
+        std::vector<PackedCell> back_;
+        // the terminal content is unknown, `present()` has to write every cell
+        bool full_redraw_ = true;
+        // look for rows that moved up or down, see `scroll()`
+        bool detect_scroll_ = true;
+        // more areas than this are merged into their bounding box
+        static const size_t MAX_DAMAGE = 16;
+
+        // `present()` diffs only the `damage()`-d areas
+        bool track_damage_ = false;
+        // disjoint-ish areas changed since the last `present()`, clipped to the `Frame`
+        std::vector<Rect> damage_;
+        // drawing outside of this is ignored, the whole `Frame` unless in `redraw()`
+        Rect clip_;
+        // of each row of `front_` and `back_`, reused by `scroll()`
+        std::vector<uint64_t> front_hashes_;
+        std::vector<uint64_t> back_hashes_;
+
+        // every style used, 0 is `Style()` without a link
+        std::vector<Pen> pens_;
+        std::unordered_map<Pen, uint16_t, PenHash> pen_ids_;
+        // the last one interned, cells tend to come in runs of the same style
+        Pen last_pen_;
+        uint16_t last_pen_id_ = 0;
+        // what the `Pen::written` styles are fit to, so rgb colors are only looked up once per style
+        ColorDepth depth_ = color_depth().load(std::memory_order_relaxed);
+        // every link target used, 0 is none
+        std::vector<std::string> links_;
+        std::unordered_map<std::string, uint32_t> link_ids_;
+        // every glyph of more than one code point used
+        std::vector<std::string> pool_;
+        std::unordered_map<std::string, uint32_t> pool_ids_;
+        size_t pool_limit_ = MIN_POOL_LIMIT;
+
+        size_t index(const Coord& coord) const {
+            return (static_cast<size_t>(coord.row - 1) * this->size_.col) + (coord.col - 1);
+        }
+
+        uint32_t intern_link(const std::string& link) {
+            if (link.empty()) {
+                return 0;
+            }
+            auto found = this->link_ids_.find(link);
+            if (found != this->link_ids_.end()) {
+                return found->second;
+            }
+            auto id = static_cast<uint32_t>(this->links_.size());
+            this->links_.push_back(link);
+            this->link_ids_.emplace(link, id);
+            return id;
+        }
+
+        // returns: the index of `style` with `link` in `pens_`, or 0 (`Style()`) if the table is full of ones in use
+        uint16_t intern(const Style& style, const std::string& link) {
+            Pen pen{style, this->intern_link(link)};
+            if (pen == this->last_pen_) {
+                return this->last_pen_id_;
+            }
+            auto found = this->pen_ids_.find(pen);
+            if (found == this->pen_ids_.end()) {
+                if (this->pens_.size() == MAX_PENS) {
+                    this->compact_pens();
+                    // renumbered the links too
+                    pen.link = this->intern_link(link);
+                    if (this->pens_.size() == MAX_PENS) {
+                        return 0;
+                    }
+                }
+                pen.written = style.fit(this->depth_);
+                found = this->pen_ids_.emplace(pen, static_cast<uint16_t>(this->pens_.size())).first;
+                this->pens_.push_back(pen);
+            }
+            this->last_pen_ = pen;
+            this->last_pen_id_ = found->second;
+            return found->second;
+        }
+
+        // returns: the utf-8 `glyph` as stored in a `PackedCell`, a space if it's empty
+        uint32_t intern_glyph(const std::string& glyph) {
+            if (glyph.empty()) {
+                return ' ';
+            }
+            const auto* at = glyph.data();
+            auto cp = unicode::decode(at, glyph.data() + glyph.size());
+            if (at == glyph.data() + glyph.size()) {
+                return cp;
+            }
+            auto found = this->pool_ids_.find(glyph);
+            if (found != this->pool_ids_.end()) {
+                return PackedCell::POOLED | found->second;
+            }
+            if (this->pool_.size() >= this->pool_limit_) {
+                this->compact_pool();
+                this->pool_limit_ = std::max(size_t{MIN_POOL_LIMIT}, 2 * this->pool_.size());
+            }
+            auto id = static_cast<uint32_t>(this->pool_.size());
+            this->pool_.push_back(glyph);
+            this->pool_ids_.emplace(glyph, id);
+            return PackedCell::POOLED | id;
+        }
+
+        // drop the styles and links no cell uses anymore, eg. after an animation went through lots of colors
+        void compact_pens() {
+            std::vector<bool> used(this->pens_.size(), false);
+            used[0] = true;
+            for (const auto* cells : {&this->front_, &this->back_}) {
+                for (const auto& cell : *cells) {
+                    used[cell.style] = true;
+                }
+            }
+            std::vector<uint16_t> ids(this->pens_.size(), 0);
+            std::vector<Pen> pens;
+            std::vector<std::string> links;
+            this->pen_ids_.clear();
+            this->link_ids_.clear();
+            for (size_t i = 0; i < this->pens_.size(); ++i) {
+                if (!used[i]) {
+                    continue;
+                }
+                auto pen = this->pens_[i];
+                auto& link = this->links_[pen.link];
+                auto found = this->link_ids_.find(link);
+                if (found == this->link_ids_.end()) {
+                    found = this->link_ids_.emplace(link, static_cast<uint32_t>(links.size())).first;
+                    links.push_back(link);
+                }
+                pen.link = found->second;
+                ids[i] = static_cast<uint16_t>(pens.size());
+                this->pen_ids_.emplace(pen, ids[i]);
+                pens.push_back(pen);
+            }
+            this->pens_ = std::move(pens);
+            this->links_ = std::move(links);
+            for (auto* cells : {&this->front_, &this->back_}) {
+                for (auto& cell : *cells) {
+                    cell.style = ids[cell.style];
+                }
+            }
+            this->last_pen_ = Pen{};
+            this->last_pen_id_ = 0;
+        }
+
+        // drop the glyphs no cell uses anymore
+        void compact_pool() {
+            const uint32_t none = UNKNOWN;
+            std::vector<uint32_t> ids(this->pool_.size(), none);
+            std::vector<std::string> pool;
+            this->pool_ids_.clear();
+            for (auto* cells : {&this->front_, &this->back_}) {
+                for (auto& cell : *cells) {
+                    if ((cell.glyph & PackedCell::POOLED) == 0 || cell.glyph == UNKNOWN) {
+                        continue;
+                    }
+                    auto& id = ids[cell.glyph & ~PackedCell::POOLED];
+                    if (id == none) {
+                        id = static_cast<uint32_t>(pool.size());
+                        pool.push_back(this->pool_[cell.glyph & ~PackedCell::POOLED]);
+                        this->pool_ids_.emplace(pool.back(), id);
+                    }
+                    cell.glyph = PackedCell::POOLED | id;
+                }
+            }
+            this->pool_ = std::move(pool);
+        }
+
+        // the utf-8 encoded glyph of `cell`
+        std::string glyph(const PackedCell& cell) const {
+            if ((cell.glyph & PackedCell::POOLED) != 0) {
+                return this->pool_[cell.glyph & ~PackedCell::POOLED];
+            }
+            char buf[unicode::MAX_UTF8];
+            return std::string(buf, unicode::encode(cell.glyph, buf));
+        }
+
+        // the wide character `ix` of the back buffer is half of loses its other half, which becomes a space
+        void split(size_t ix) {
+            const auto& cell = this->back_[ix];
+            if (cell.wide()) {
+                this->back_[ix + 1] = PackedCell(' ', cell.style);
+            } else if (cell.continuation()) {
+                this->back_[ix - 1] = PackedCell(' ', cell.style);
+            }
+        }
+
+        // put `glyph` at `coord` of the back buffer, which has to be in `clip_`, a wide one takes the next cell too
+        // returns: false if it was wide, but didn't fit, a space is put there instead
+        bool place(const Coord& coord, uint32_t glyph, uint16_t style, size_t width) {
+            auto ix = this->index(coord);
+            this->split(ix);
+            if (width < 2) {
+                this->back_[ix] = PackedCell(glyph, style);
+                return true;
+            }
+            if (coord.col + 1 > this->clip_.end.col) {
+                this->back_[ix] = PackedCell(' ', style);
+                return false;
+            }
+            this->split(ix + 1);
+            this->back_[ix] = PackedCell(glyph, style, PackedCell::WIDE);
+            this->back_[ix + 1] = PackedCell(glyph, style, PackedCell::CONTINUATION);
+            return true;
+        }
+
+        // add the combining `cp` to the character at `ix` of the back buffer
+        void combine(size_t ix, char32_t cp) {
+            char buf[unicode::MAX_UTF8];
+            auto glyph = this->glyph(this->back_[ix]);
+            glyph.append(buf, unicode::encode(cp, buf));
+            auto packed = this->intern_glyph(glyph);
+            this->back_[ix].glyph = packed;
+            if (this->back_[ix].wide()) {
+                this->back_[ix + 1].glyph = packed;
+            }
+        }
+
+        // `with` as it's stored, a wide one is a space, as it would need two cells
+        PackedCell pack_fill(const Cell& with) {
+            auto style = this->intern(with.style, with.link);
+            if (unicode::display_width(with.glyph) > 1) {
+                return PackedCell(' ', style);
+            }
+            return PackedCell(this->intern_glyph(with.glyph), style);
+        }
+
+        // of every cell in `row` (starting at 0) of `cells`, 8 bytes at a time
+        uint64_t row_hash(const std::vector<PackedCell>& cells, unsigned row) const {
+            uint64_t hash = 14695981039346656037ULL;
+            const auto* cell = &cells[static_cast<size_t>(row) * this->size_.col];
+            for (unsigned col = 0; col < this->size_.col; ++col, ++cell) {
+                uint64_t word = 0;
+                std::memcpy(&word, cell, sizeof(word));
+                hash = (hash ^ word) * 1099511628211ULL;
+                hash ^= hash >> 32U;
+            }
+            return hash;
+        }
+        bool rows_equal(unsigned back_row, unsigned front_row) const {
+            auto cols = static_cast<size_t>(this->size_.col);
+            return std::memcmp(&this->back_[back_row * cols], &this->front_[front_row * cols],
+                               cols * sizeof(PackedCell)) == 0;
+        }
+
+        // if a block of rows moved up or down since the last `present()` (eg. a log got a new line), move it on the
+        // terminal too, with a scroll region and SU/SD, and update `front_` to match
+        // so only the rows scrolled into view differ, instead of every row of the block
+        // WARN: the style has to be reset before, otherwise the exposed rows are erased with its background
+        // returns: whether it scrolled
+        bool scroll(SgrState& sgr) {
+            const auto rows = this->size_.row;
+            const auto cols = static_cast<size_t>(this->size_.col);
+            if (rows < 2 || cols == 0) {
+                return false;
+            }
+            this->front_hashes_.resize(rows);
+            this->back_hashes_.resize(rows);
+            bool changed = false;
+            for (unsigned row = 0; row < rows; ++row) {
+                this->front_hashes_[row] = this->row_hash(this->front_, row);
+                this->back_hashes_[row] = this->row_hash(this->back_, row);
+                changed |= this->front_hashes_[row] != this->back_hashes_[row];
+            }
+            if (!changed) {
+                return false;
+            }
+
+            // every changed row votes for where it was before, blank ones are everywhere, so they don't
+            // `shift` is by how much the rows moved up, negative if down
+            const std::vector<PackedCell> blank(cols);
+            const auto blank_hash = this->row_hash(blank, 0);
+            std::vector<unsigned> votes((2 * rows) - 1, 0);
+            for (unsigned row = 0; row < rows; ++row) {
+                auto hash = this->back_hashes_[row];
+                if (hash == this->front_hashes_[row] || hash == blank_hash) {
+                    continue;
+                }
+                for (unsigned from = 0; from < rows; ++from) {
+                    if (this->front_hashes_[from] == hash) {
+                        ++votes[from + rows - 1 - row];
+                        break;
+                    }
+                }
+            }
+            int shift = 0;
+            unsigned best = 0;
+            for (size_t i = 0; i < votes.size(); ++i) {
+                if (votes[i] > best) {
+                    best = votes[i];
+                    shift = static_cast<int>(i) - static_cast<int>(rows - 1);
+                }
+            }
+            if (shift == 0) {
+                return false;
+            }
+
+            // the longest run of rows in [`first`;`last`] that are where they were, moved by `shift`
+            // `gain` is the rows that were changed, but won't be after scrolling
+            int first = 0;
+            int last = -1;
+            int gain = 0;
+            for (int row = 0; row < static_cast<int>(rows);) {
+                int run = 0;
+                int run_gain = 0;
+                for (; row + run < static_cast<int>(rows); ++run) {
+                    auto from = row + run + shift;
+                    if (from < 0 || from >= static_cast<int>(rows) ||
+                        this->back_hashes_[row + run] != this->front_hashes_[from]) {
+                        break;
+                    }
+                    run_gain += (this->back_hashes_[row + run] != this->front_hashes_[row + run]) ? 1 : 0;
+                }
+                if (run_gain > gain) {
+                    first = row;
+                    last = row + run - 1;
+                    gain = run_gain;
+                }
+                row += (run == 0) ? 1 : run;
+            }
+            // a row costs at least as much as the few sequences of a scroll
+            if (gain < 2) {
+                return false;
+            }
+            for (auto row = first; row <= last; ++row) {
+                if (!this->rows_equal(static_cast<unsigned>(row), static_cast<unsigned>(row + shift))) {
+                    // a collision, better safe than sorry
+                    return false;
+                }
+            }
+
+            // the region covers where the block was and where it is now
+            auto top = (shift > 0) ? first : first + shift;
+            auto bottom = (shift > 0) ? last + shift : last;
+            auto by = static_cast<unsigned>((shift > 0) ? shift : -shift);
+            char seq[encode::MAX_SEQ];
+            put(seq, sgr.style(seq, Style()));
+            tui::screen::scroll_region(static_cast<unsigned>(top + 1), static_cast<unsigned>(bottom + 1));
+            if (shift > 0) {
+                tui::screen::scroll_up(by);
+            } else {
+                tui::screen::scroll_down(by);
+            }
+            tui::screen::reset_scroll_region();
+
+            // the terminal did the same to its rows
+            auto row_begin = [&](int row) { return this->front_.begin() + static_cast<std::ptrdiff_t>(row * cols); };
+            if (shift > 0) {
+                std::move(row_begin(top + static_cast<int>(by)), row_begin(bottom + 1), row_begin(top));
+                std::fill(row_begin(bottom + 1 - static_cast<int>(by)), row_begin(bottom + 1), PackedCell{});
+            } else {
+                std::move_backward(row_begin(top), row_begin(bottom + 1 - static_cast<int>(by)), row_begin(bottom + 1));
+                std::fill(row_begin(top), row_begin(top + static_cast<int>(by)), PackedCell{});
+            }
+            return true;
+        }
+
+        // write the cells of `rect` that changed, see `present()`
+        void present_area(const Rect& rect, Coord& cursor, SgrState& sgr, unsigned& written) {
+            const PackedCell unknown(UNKNOWN, 0);
+            for (auto row = rect.start.row; row <= rect.end.row; ++row) {
+                // so `base + col` is the index of (`row`;`col`)
+                auto base = this->index(Coord{row, 1}) - 1;
+                if (std::memcmp(&this->back_[base + rect.start.col], &this->front_[base + rect.start.col],
+                                rect.cols() * sizeof(PackedCell)) == 0) {
+                    continue;
+                }
+                auto last = rect.end.col;
+                for (auto col = rect.start.col; col <= last; ++col) {
+                    if (this->back_[base + col] == this->front_[base + col]) {
+                        continue;
+                    }
+
+                    // a wide character is written from its left half
+                    // and writing over either half of one on the terminal erases the other, so that's written first
+                    auto at = col;
+                    while (this->back_[base + at].continuation() || this->front_[base + at].continuation()) {
+                        if (!this->back_[base + at].continuation()) {
+                            this->front_[base + at] = unknown;
+                        }
+                        --at;
+                    }
+                    const auto& cell = this->back_[base + at];
+                    unsigned width = cell.wide() ? 2 : 1;
+                    if (this->front_[base + at + width - 1].wide()) {
+                        this->front_[base + at + width] = unknown;
+                        last = std::max(last, at + width);
+                    }
+
+                    if (cursor != Coord{row, at}) {
+                        tui::cursor::move_to(row, at);
+                    }
+                    // only what differs from the previous cell
+                    const auto& pen = this->pens_[cell.style];
+                    char seq[encode::MAX_SEQ];
+                    put(seq, sgr.style(seq, pen.written));
+                    std::cout << sgr.link(this->links_[pen.link]);
+                    if ((cell.glyph & PackedCell::POOLED) != 0) {
+                        std::cout << this->pool_[cell.glyph & ~PackedCell::POOLED];
+                    } else {
+                        char buf[unicode::MAX_UTF8];
+                        std::cout.write(buf, unicode::encode(cell.glyph, buf) - buf);
+                    }
+                    cursor = Coord{row, at + width};
+
+                    std::copy_n(&this->back_[base + at], width, &this->front_[base + at]);
+                    written += width;
+                    col = at + width - 1;
+                }
+            }
+        }
+
+      public:
+        // sized to the terminal screen
+        Frame() : Frame(Coord::screen_size()) {}
+        explicit Frame(const Coord& size) : pens_(1), links_(1) {
+            this->pen_ids_.emplace(Pen{}, 0);
+            this->link_ids_.emplace("", 0);
+            this->resize(size);
+        }
+
+        // (rows;cols)
+        Coord size() const { return this->size_; }
+
+        // resize both buffers, discards all content and forces a full redraw on the next `present()`
+        void resize(const Coord& size) {
+            this->size_ = size;
+            this->clip_ = this->area();
+            this->damage_.clear();
+            auto cells = static_cast<size_t>(size.row) * size.col;
+            this->front_.assign(cells, PackedCell{});
+            this->back_.assign(cells, PackedCell{});
+            this->invalidate();
+        }
+
+        // forget what's on the terminal, eg. after `screen::clear()` or anything else drawn around the `Frame`
+        void invalidate() { this->full_redraw_ = true; }
+
+        // look for rows that moved up or down since the last `present()`, and scroll them on the terminal instead
+        // of writing them again, on by default
+        // NOTE: only if the `Frame` is as wide as the screen (see `Output::set_width()`), as the terminal scrolls
+        // whole rows
+        void detect_scroll(bool enable) { this->detect_scroll_ = enable; }
+
+        // fill the back buffer with `with`, a wide character is a space instead
+        void clear(const Cell& with = Cell{}) {
+            std::fill(this->back_.begin(), this->back_.end(), this->pack_fill(with));
+        }
+
+        // (1;1)-`size()`
+        Rect area() const { return Rect{Coord{1, 1}, this->size_}; }
+
+        // is `coord` inside the `Frame`
+        bool contains(const Coord& coord) const {
+            return (coord.row >= 1 && coord.col >= 1 && coord <= this->size_);
+        }
+
+        // only diff the `damage()`-d areas in `present()`, instead of every cell, off by default
+        // so the cost of a frame is down to what changed, not the size of the terminal
+        void track_damage(bool enable) { this->track_damage_ = enable; }
+
+        // `area` has to be redrawn (with `redraw()`) and written (by `present()`), clipped to the `Frame`
+        // overlapping or touching areas are merged as long as that doesn't add many cells that didn't change
+        void damage(const Rect& area) {
+            auto rect = area.intersection(this->area());
+            if (rect.empty()) {
+                return;
+            }
+            for (size_t i = 0; i < this->damage_.size();) {
+                auto merged = this->damage_[i].merged(rect);
+                if (merged.area() > this->damage_[i].area() + rect.area()) {
+                    ++i;
+                    continue;
+                }
+                // the merged one might reach others now, start over
+                rect = merged;
+                this->damage_.erase(this->damage_.begin() + static_cast<std::ptrdiff_t>(i));
+                i = 0;
+            }
+            this->damage_.push_back(rect);
+            // too many small ones cost more than their bounding box
+            if (this->damage_.size() > MAX_DAMAGE) {
+                Rect all;
+                for (const auto& each : this->damage_) {
+                    all = all.merged(each);
+                }
+                this->damage_.assign(1, all);
+            }
+        }
+        // since the last `present()`
+        const std::vector<Rect>& damaged() const { return this->damage_; }
+
+        // for every `damage()`-d area: fill it with `with`, then call `draw(const Rect& area)`, which only has to
+        // draw what's in `area`, as `set()` and `print()` ignore everything outside of it
+        template <typename Fn> void redraw(Fn draw, const Cell& with = Cell{}) {
+            for (const auto& rect : this->damage_) {
+                // packed again every time, `draw` might've compacted the pens and the glyphs, renumbering them
+                auto fill = this->pack_fill(with);
+                for (auto row = rect.start.row; row <= rect.end.row; ++row) {
+                    auto from = this->index({row, rect.start.col});
+                    // the halves of wide characters cut by the edges
+                    this->split(from);
+                    this->split(from + rect.cols() - 1);
+                    std::fill_n(this->back_.begin() + static_cast<std::ptrdiff_t>(from), rect.cols(), fill);
+                }
+                this->clip_ = rect;
+                draw(static_cast<const Rect&>(rect));
+            }
+            this->clip_ = this->area();
+        }
+
+        // cell of the back buffer at `coord`, which has to be `contains()`-ed
+        // INFO: unpacked into a new `Cell`, use `set()` to change it
+        Cell at(const Coord& coord) const {
+            const auto& cell = this->back_[this->index(coord)];
+            const auto& pen = this->pens_[cell.style];
+            return Cell(cell.continuation() ? "" : this->glyph(cell), pen.style, this->links_[pen.link]);
+        }
+
+        // set the cell at `coord`, does nothing if it's off the `Frame` (or the area being `redraw()`-n)
+        // a wide character takes the cell after `coord` too, it's a space if that's off
+        void set(const Coord& coord, const Cell& cell) {
+            if (this->clip_.contains(coord)) {
+                this->place(coord, this->intern_glyph(cell.glyph), this->intern(cell.style, cell.link),
+                          unicode::display_width(cell.glyph));
+            }
+        }
+        // the same with a single code point, without building a `Cell`
+        void set(const Coord& coord, char32_t glyph, const Style& style = Style()) {
+            if (this->clip_.contains(coord)) {
+                this->place(coord, glyph, this->intern(style, ""), unicode::width(glyph));
+            }
+        }
+
+        // write utf-8 `text` starting at `coord`, clipped to the right edge (and to the area being `redraw()`-n)
+        // wide characters take two cells, combining ones are added to the one before, control ones are skipped
+        // returns: the number of cells up to the right edge, including the ones clipped on the left
+        unsigned print(const Coord& coord, const std::string& text, const Style& style = Style(),
+                       const std::string& link = "") {
+            const auto& clip = this->clip_;
+            if (coord.row < clip.start.row || coord.row > clip.end.row || coord.col > clip.end.col || coord.col == 0) {
+                return 0;
+            }
+            auto pen = this->intern(style, link);
+            const unsigned right = clip.end.col - coord.col + 1;
+            unsigned written = 0;
+            // where the previous character went, if it's in `clip_`
+            const size_t none = this->back_.size();
+            auto prev = none;
+            const auto* at = text.data();
+            const auto* end = at + text.size();
+            while (at != end && written < right) {
+                auto cp = unicode::decode(at, end);
+                auto width = unicode::width(cp);
+                if (width == 0) {
+                    if (prev != none && cp >= 0x20 && cp != 0x7F) {
+                        this->combine(prev, cp);
+                    }
+                    continue;
+                }
+                Coord to{coord.row, coord.col + written};
+                written += width;
+                prev = none;
+                if (to.col >= clip.start.col) {
+                    if (this->place(to, cp, pen, width)) {
+                        prev = this->index(to);
+                    }
+                } else if (width == 2 && to.col + 1 == clip.start.col) {
+                    // only its right half would be inside
+                    this->place({to.row, to.col + 1}, ' ', pen, 1);
+                }
+            }
+            return std::min(written, right);
+        }
+
+        // write every changed cell of the back buffer to `std::cout`
+        // does not flush, the caller decides when the frame is complete
+        // returns: the number of cells written
+        unsigned present() {
+            unsigned written = 0;
+            // where the terminal cursor is after our last write, (0;0) if unknown
+            Coord cursor;
+            // the terminal style is unknown, but no link should be open
+            SgrState sgr;
+            // the terminal shows the colors fit to the old depth
+            auto depth = color_depth().load(std::memory_order_relaxed);
+            if (depth != this->depth_) {
+                this->depth_ = depth;
+                for (auto& pen : this->pens_) {
+                    pen.written = pen.style.fit(depth);
+                }
+                this->invalidate();
+            }
+            // the terminal scrolls whole rows, which would take whatever is next to a narrower `Frame` too
+            // and with damage tracking the rows scrolled into view might not be damaged
+            if (!this->full_redraw_ && !this->track_damage_ && this->detect_scroll_) {
+                auto screen_cols = tui::output().width();
+                if (screen_cols == 0) {
+                    // not attached, ask the terminal
+                    screen_cols = screen::size().second;
+                }
+                if (screen_cols == this->size_.col) {
+                    // leaves the cursor home
+                    this->scroll(sgr);
+                }
+            }
+
+            if (this->full_redraw_) {
+                this->damage_.assign(1, this->area());
+                std::fill(this->front_.begin(), this->front_.end(), PackedCell(UNKNOWN, 0));
+            } else if (!this->track_damage_) {
+                this->damage_.assign(1, this->area());
+            }
+            for (const auto& rect : this->damage_) {
+                this->present_area(rect, cursor, sgr, written);
+            }
+            this->damage_.clear();
+
+            std::cout << sgr.link("");
+            if (sgr.known() && !sgr.style().empty()) {
+                std::cout << tui::text::style::reset_style();
+            }
+            this->full_redraw_ = false;
+            return written;
+        }
+    };
+} // namespace tui
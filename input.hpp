@@ -1,14 +1,22 @@
 #pragma once
 
 #include "tui.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
 #include <iostream>
+#include <string>
+#include <type_traits>
 
 // Platform-specific includes
 #ifdef _WIN32
 #include <conio.h>   // For _kbhit() and _getch() on Windows
 #include <windows.h> // For GetConsoleMode and SetConsoleMode
 #else
-#include <fcntl.h>   // For fcntl() on Unix-like systems
+#include <poll.h>    // For poll() on Unix-like systems
 #include <termios.h> // For termios on Unix-like systems
 #include <unistd.h>  // For read(), usleep() on Unix-like systems
 #endif
@@ -22,7 +30,6 @@
 // Define Enum Member
 #define DEM(X1, X2, X3, X4) _DCEM(X1), _DCEM(X2), _DCEM(X3), _DCEM(X4)
 
-// TODO: maybe add keys: F(5-12) NOTE: shall need an own `struct F {num: u8}`, ...
 enum SpecKey {
     CtrlA = 1,
     DEM(B, C, D, E),
@@ -46,6 +53,15 @@ enum SpecKey {
     F3 = 82,
     F4 = 83,
     ShiftTab = 90,
+    // these have no byte of their own, they arrive as `CSI <n>~`
+    F5 = 100,
+    F6 = 101,
+    F7 = 102,
+    F8 = 103,
+    F9 = 104,
+    F10 = 105,
+    F11 = 106,
+    F12 = 107,
     Backspace = 127,
     None,
 };
@@ -59,6 +75,14 @@ enum Arrow {
     Left = 68,
 };
 
+// modifier keys held down, as the terminal reports them: bits of `<n> - 1` in eg. `CSI 1;<n>A`
+enum Mod {
+    Shift = 1,
+    Alt = 2,
+    Ctrl = 4,
+    Meta = 8,
+};
+
 // `case`, return as `string`
 #define CRS(X)                                                                                                         \
     case X:                                                                                                            \
@@ -73,6 +97,8 @@ inline std::ostream& operator<<(std::ostream& os, const SpecKey& special) {
     switch (special) {
         CRSS(Esc, Tab, Backspace, Enter);
         CRSS(F1, F2, F3, F4);
+        CRSS(F5, F6, F7, F8);
+        CRSS(F9, F10, F11, F12);
         CRSS(Home, End, PageUp, PageDown);
         CRSS(ShiftTab, Insert, Delete, None);
     default:
@@ -92,57 +118,177 @@ inline std::ostream& operator<<(std::ostream& os, const Arrow& arrow) {
     }
     return os;
 }
+inline std::ostream& operator<<(std::ostream& os, const Mod& mod) {
+    switch (mod) {
+        CRSS(Shift, Alt, Ctrl, Meta);
+    default:
+        os << "Unknown";
+    }
+    return os;
+}
 #undef CRS
 #undef CRSS
 
+// a mouse report, enabled with `tui::mouse::enable()`
+struct Mouse {
+    enum class Kind : uint8_t {
+        Press = 0,
+        Release,
+        // with `button` held down, or `Button::None` for plain motion
+        Move,
+        // `count` notches of `button`
+        Wheel,
+    };
+    enum class Button : uint8_t {
+        Left = 0,
+        Middle,
+        Right,
+        None,
+        WheelUp,
+        WheelDown,
+        WheelLeft,
+        WheelRight,
+        Back,
+        Forward,
+    };
+
+    Kind kind = Kind::Press;
+    Button button = Button::None;
+    // (row;col) where it happened, (1;1) being the top left cell
+    unsigned row = 1;
+    unsigned col = 1;
+    // the number of reports merged into this one, see `InputReader::coalesce()`
+    unsigned count = 1;
+
+    bool operator==(const Mouse& other) const {
+        return (this->kind == other.kind && this->button == other.button && this->row == other.row &&
+                this->col == other.col && this->count == other.count);
+    }
+    bool operator!=(const Mouse& other) const { return !(*this == other); }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const Mouse& mouse) {
+    static const char* const KINDS[] = {"Press", "Release", "Move", "Wheel"};
+    static const char* const BUTTONS[] = {"Left",    "Middle",    "Right",      "None", "WheelUp",
+                                          "WheelDown", "WheelLeft", "WheelRight", "Back", "Forward"};
+    os << KINDS[static_cast<unsigned>(mouse.kind)] << ' ' << BUTTONS[static_cast<unsigned>(mouse.button)] << " ("
+       << mouse.row << ';' << mouse.col << ')';
+    if (mouse.count != 1) {
+        os << " x" << mouse.count;
+    }
+    return os;
+}
+
 struct Input {
     bool is_ch = false;
     bool is_arrow = false;
     bool is_special = false;
+    bool is_mouse = false;
+    bool is_paste = false;
 
+    // the character if it's ascii, '\0' otherwise
     char ch = '\0';
+    // the unicode code point of the character, U+FFFD (REPLACEMENT CHARACTER) if its utf-8 encoding was invalid
+    char32_t codepoint = 0;
     Arrow arrow = static_cast<Arrow>(0);
     SpecKey special = SpecKey::None;
+    Mouse mouse;
+    // `paste_size` bytes pasted while bracketed paste was on (`tui::bracketed_paste()`), as is, control bytes included
+    // WARN: points into the reader's buffer, only valid until the next `Input` is read, `paste_str()` copies it
+    const char* paste = nullptr;
+    size_t paste_size = 0;
+    // `Mod`s held down, eg. `Ctrl | Shift`
+    unsigned char mods = 0;
+
+    // integers that'd be ambiguous between `char` and `char32_t`
+    template <typename T>
+    struct is_other_integer
+        : std::integral_constant<bool, std::is_integral<T>::value && !std::is_same<T, char>::value &&
+                                           !std::is_same<T, char32_t>::value && !std::is_same<T, bool>::value> {};
 
     Input() = default;
     Input(const Arrow& arrow) : is_arrow(true), arrow(arrow) {}
-    Input(const char& ch) : is_ch(true), ch(ch) {}
+    Input(const char& ch) : is_ch(true), ch(ch), codepoint(static_cast<unsigned char>(ch)) {}
+    Input(const char32_t& codepoint)
+        : is_ch(true), ch(codepoint < 0x80 ? static_cast<char>(codepoint) : '\0'), codepoint(codepoint) {}
+    // any other integer is a codepoint too, so eg. `Input(27)` isn't ambiguous between `char` and `char32_t`
+    template <typename T, typename = typename std::enable_if<Input::is_other_integer<T>::value>::type>
+    Input(T codepoint) : Input(static_cast<char32_t>(codepoint)) {}
     Input(const SpecKey& special) : is_special(true), special(special) {}
+    Input(const Mouse& mouse) : is_mouse(true), mouse(mouse) {}
+    Input(const char* paste, size_t size) : is_paste(true), paste(paste), paste_size(size) {}
 
     bool operator==(const Input& other) const {
-        return (this->ch == other.ch && this->is_ch == other.is_ch && this->arrow == other.arrow &&
+        return (this->ch == other.ch && this->codepoint == other.codepoint && this->is_ch == other.is_ch &&
+                this->arrow == other.arrow &&
                 this->is_arrow == other.is_arrow && this->special == other.special &&
-                this->is_special == other.is_special);
+                this->is_special == other.is_special && this->is_mouse == other.is_mouse &&
+                this->mouse == other.mouse && this->is_paste == other.is_paste &&
+                this->paste_size == other.paste_size &&
+                // NOTE: `paste` may be null when empty, `memcmp` mustn't get that even for 0 bytes
+                (this->paste_size == 0 || std::memcmp(this->paste, other.paste, this->paste_size) == 0) &&
+                this->mods == other.mods);
     }
+    // NOTE: the comparisons below don't care about `mods`, use `has()` for them
     bool operator==(const char& other) const { return (this->is_ch && this->ch == other); }
+    bool operator==(const char32_t& other) const { return (this->is_ch && this->codepoint == other); }
+    // eg. `input == 27`, compared as a codepoint
+    template <typename T, typename = typename std::enable_if<Input::is_other_integer<T>::value>::type>
+    bool operator==(T other) const {
+        return *this == static_cast<char32_t>(other);
+    }
     bool operator==(const SpecKey& other) const { return (this->is_special && this->special == other); }
     bool operator==(const Arrow& other) const { return (this->is_arrow && this->arrow == other); }
 
     bool operator!=(const char& other) const { return !(*this == other); }
+    bool operator!=(const char32_t& other) const { return !(*this == other); }
+    template <typename T, typename = typename std::enable_if<Input::is_other_integer<T>::value>::type>
+    bool operator!=(T other) const {
+        return !(*this == other);
+    }
     bool operator!=(const SpecKey& other) const { return !(*this == other); }
     bool operator!=(const Arrow& other) const { return !(*this == other); }
     bool operator!=(const Input& other) const { return !(*this == other); }
 
-    friend std::ostream& operator<<(std::ostream& os, const Input& inp);
+    std::string paste_str() const { return std::string(this->paste, this->paste_size); }
 
-  private:
-    // Function to set stdin non-blocking on Unix-like systems
-#ifndef _WIN32
-    static void set_non_blocking(bool enable) {
-        int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
-        fcntl(STDIN_FILENO, F_SETFL, enable ? flags | O_NONBLOCK : flags & ~O_NONBLOCK);
+    // the utf-8 encoding of `codepoint`
+    std::string utf8() const {
+        char buf[tui::unicode::MAX_UTF8];
+        return std::string(buf, tui::unicode::encode(this->codepoint, buf));
+    }
+
+    // is `mod` held down
+    bool has(const Mod& mod) const { return (this->mods & mod) != 0; }
+
+    // merge `next` into this one if they're both `Mouse::Kind::Move` or both `Mouse::Kind::Wheel` the same way
+    // returns: false if they can't be merged
+    bool coalesce(const Input& next) {
+        if (!this->is_mouse || !next.is_mouse || this->mods != next.mods || this->mouse.kind != next.mouse.kind ||
+            this->mouse.button != next.mouse.button) {
+            return false;
+        }
+        if (this->mouse.kind != Mouse::Kind::Move && this->mouse.kind != Mouse::Kind::Wheel) {
+            return false;
+        }
+        auto count = this->mouse.count + next.mouse.count;
+        this->mouse = next.mouse;
+        this->mouse.count = count;
+        return true;
     }
-#endif
 
+    friend std::ostream& operator<<(std::ostream& os, const Input& inp);
+
+  private:
+#ifdef _WIN32
     using reader_fn = char (*)();
     static Input read_helper(reader_fn get_char) {
         char byte = get_char();
 
         auto input = Input(SpecKey::None);
-#ifdef _WIN32
         if (byte == 0 || byte == 224 || byte == -32) {
             char next_byte = get_char();
-            switch (next_byte) {
+            switch (static_cast<unsigned char>(next_byte)) {
             case 59:
                 return Input(SpecKey::F1);
             case 60:
@@ -151,6 +297,22 @@ struct Input {
                 return Input(SpecKey::F3);
             case 62:
                 return Input(SpecKey::F4);
+            case 63:
+                return Input(SpecKey::F5);
+            case 64:
+                return Input(SpecKey::F6);
+            case 65:
+                return Input(SpecKey::F7);
+            case 66:
+                return Input(SpecKey::F8);
+            case 67:
+                return Input(SpecKey::F9);
+            case 68:
+                return Input(SpecKey::F10);
+            case 133:
+                return Input(SpecKey::F11);
+            case 134:
+                return Input(SpecKey::F12);
             case 72:
                 return Input(Arrow::Up);
             case 75:
@@ -175,11 +337,6 @@ struct Input {
                 break;
             }
         }
-#else
-        if (byte < 0) {
-            get_char(); // ignore
-        }
-#endif
         if (byte >= 32 && byte <= 126) { // <char>
             input = Input(byte);
         } else if (byte >= 1 && byte <= 26) { // Ctrl<char>
@@ -188,55 +345,15 @@ struct Input {
 
         switch (byte) {
         case SpecKey::Backspace:
+        case SpecKey::Esc:
             input = Input(static_cast<SpecKey>(byte));
             break;
-        case SpecKey::Esc: {
-#ifndef _WIN32
-            set_non_blocking(true);
-            char next_byte = get_char();
-
-            if (next_byte == 79 || next_byte == 91) {
-                char special = get_char();
-                switch (special) {
-                case Arrow::Up:
-                case Arrow::Down:
-                case Arrow::Right:
-                case Arrow::Left:
-                    input = Input(static_cast<Arrow>(special));
-                    break;
-                case SpecKey::F1:
-                case SpecKey::F2:
-                case SpecKey::F3:
-                case SpecKey::F4:
-                case SpecKey::End:
-                case SpecKey::Home:
-                case SpecKey::ShiftTab:
-                    input = Input(static_cast<SpecKey>(special));
-                    break;
-                case SpecKey::Insert:
-                case SpecKey::Delete:
-                case SpecKey::PageUp:
-                case SpecKey::PageDown:
-                    get_char(); // ignore '~'
-                    input = Input(static_cast<SpecKey>(special));
-                    break;
-                default:
-                    // ignore_byte = get_char();
-                    break;
-                }
-            } else {
-                input = Input(SpecKey::Esc);
-            }
-            set_non_blocking(false);
-            break;
-#endif
-            input = Input(SpecKey::Esc);
-        }
         default:
             break;
         }
         return input;
     }
+#endif
 
   public:
 // TODO: test
@@ -246,29 +363,768 @@ struct Input {
         return tmp;
     }
 #else // not windows
+    // NOTE: reads past `read()`'s buffer, don't mix the two
     static char read_ch() {
         char tmp = 0;
         ::read(STDIN_FILENO, &tmp, 1);
         return tmp;
     }
 #endif
-    static Input read() {
-        // read raw input
-        return Input::read_helper(Input::read_ch);
+    // read raw input, blocks until there's some
+    static Input read();
+};
+
+// decodes raw terminal input into `Input`s, a byte at a time, with the state machine of a VT500 (see
+// https://vt100.net/emu/dec_ansi_parser), so CSI, SS3, OSC and DCS sequences are all consumed whole, whatever they are
+// the state is kept between calls, so a sequence split by two `read()`s is decoded just fine, nothing is allocated
+// NOTE: OSC, DCS, SOS, PM and APC strings are skipped, as are the sequences with no `Input` of their own
+// INFO: a bracketed paste is delivered whole, pointing into the buffer it was fed in, if it was split between
+// buffers it's collected (and allocated for) first
+class InputParser {
+  public:
+    static const unsigned MAX_PARAMS = 16;
+
+  private:
+    enum State : uint8_t {
+        Ground = 0,
+        Escape,
+        EscapeIntermediate,
+        CsiEntry,
+        CsiParam,
+        CsiIntermediate,
+        CsiIgnore,
+        // ESC O, not part of the VT500's, some keys are sent with it
+        Ss3,
+        OscString,
+        DcsEntry,
+        DcsParam,
+        DcsIntermediate,
+        DcsPassthrough,
+        DcsIgnore,
+        SosPmApcString,
+        STATES,
+    };
+    enum Action : uint8_t {
+        Ignore = 0,
+        Print,
+        Execute,
+        Collect,
+        Param,
+        EscDispatch,
+        CsiDispatch,
+        Ss3Dispatch,
+        // the first byte of a utf-8 sequence
+        Utf8,
+    };
+
+    // what to do and where to go on each byte in each state, packed as `(action << 4) | state`
+    struct Table {
+        uint8_t next[STATES][256];
+
+        void set(State state, unsigned from, unsigned to, Action action, State next_state) {
+            for (auto byte = from; byte <= to; ++byte) {
+                this->next[state][byte] = static_cast<uint8_t>((action << 4U) | next_state);
+            }
+        }
+        // C0 controls, without CAN, SUB and ESC
+        void controls(State state, Action action, State next_state) {
+            this->set(state, 0x00, 0x17, action, next_state);
+            this->set(state, 0x19, 0x19, action, next_state);
+            this->set(state, 0x1C, 0x1F, action, next_state);
+        }
+
+        Table() {
+            for (unsigned state = 0; state < STATES; ++state) {
+                auto self = static_cast<State>(state);
+                this->set(self, 0x00, 0xFF, Ignore, self);
+                // anywhere
+                this->set(self, 0x18, 0x18, Execute, Ground);
+                this->set(self, 0x1A, 0x1A, Execute, Ground);
+                this->set(self, 0x1B, 0x1B, Ignore, Escape);
+            }
+
+            this->controls(Ground, Execute, Ground);
+            this->set(Ground, 0x20, 0x7E, Print, Ground);
+            this->set(Ground, 0x7F, 0x7F, Execute, Ground);
+            this->set(Ground, 0x80, 0xFF, Utf8, Ground);
+
+            // Alt+<key> arrives as ESC <key>
+            this->controls(Escape, Execute, Ground);
+            this->set(Escape, 0x20, 0x2F, Collect, EscapeIntermediate);
+            this->set(Escape, 0x30, 0x7F, EscDispatch, Ground);
+            this->set(Escape, 0x80, 0xFF, Utf8, Ground);
+            this->set(Escape, '[', '[', Ignore, CsiEntry);
+            this->set(Escape, ']', ']', Ignore, OscString);
+            this->set(Escape, 'O', 'O', Ignore, Ss3);
+            this->set(Escape, 'P', 'P', Ignore, DcsEntry);
+            this->set(Escape, 'X', 'X', Ignore, SosPmApcString);
+            this->set(Escape, '^', '^', Ignore, SosPmApcString);
+            this->set(Escape, '_', '_', Ignore, SosPmApcString);
+
+            this->controls(EscapeIntermediate, Execute, EscapeIntermediate);
+            this->set(EscapeIntermediate, 0x20, 0x2F, Collect, EscapeIntermediate);
+            this->set(EscapeIntermediate, 0x30, 0x7E, EscDispatch, Ground);
+
+            this->controls(CsiEntry, Execute, CsiEntry);
+            this->set(CsiEntry, 0x20, 0x2F, Collect, CsiIntermediate);
+            this->set(CsiEntry, 0x30, 0x3B, Param, CsiParam);
+            this->set(CsiEntry, 0x3C, 0x3F, Collect, CsiParam);
+            this->set(CsiEntry, 0x40, 0x7E, CsiDispatch, Ground);
+            this->set(CsiEntry, 0x80, 0xFF, Ignore, CsiIgnore);
+
+            this->controls(CsiParam, Execute, CsiParam);
+            this->set(CsiParam, 0x20, 0x2F, Collect, CsiIntermediate);
+            this->set(CsiParam, 0x30, 0x3B, Param, CsiParam);
+            this->set(CsiParam, 0x3C, 0x3F, Ignore, CsiIgnore);
+            this->set(CsiParam, 0x40, 0x7E, CsiDispatch, Ground);
+            this->set(CsiParam, 0x80, 0xFF, Ignore, CsiIgnore);
+
+            this->controls(CsiIntermediate, Execute, CsiIntermediate);
+            this->set(CsiIntermediate, 0x20, 0x2F, Collect, CsiIntermediate);
+            this->set(CsiIntermediate, 0x30, 0x3F, Ignore, CsiIgnore);
+            this->set(CsiIntermediate, 0x40, 0x7E, CsiDispatch, Ground);
+            this->set(CsiIntermediate, 0x80, 0xFF, Ignore, CsiIgnore);
+
+            this->controls(CsiIgnore, Execute, CsiIgnore);
+            this->set(CsiIgnore, 0x40, 0x7E, Ignore, Ground);
+
+            this->controls(Ss3, Execute, Ss3);
+            this->set(Ss3, 0x20, 0x2F, Ignore, Ground);
+            this->set(Ss3, 0x30, 0x3B, Param, Ss3);
+            this->set(Ss3, 0x3C, 0x3F, Ignore, Ground);
+            this->set(Ss3, 0x40, 0x7E, Ss3Dispatch, Ground);
+            this->set(Ss3, 0x80, 0xFF, Ignore, Ground);
+
+            // ended by BEL or ST (ESC \)
+            this->set(OscString, 0x07, 0x07, Ignore, Ground);
+
+            this->set(DcsEntry, 0x20, 0x2F, Collect, DcsIntermediate);
+            this->set(DcsEntry, 0x30, 0x39, Param, DcsParam);
+            this->set(DcsEntry, 0x3A, 0x3A, Ignore, DcsIgnore);
+            this->set(DcsEntry, 0x3B, 0x3B, Param, DcsParam);
+            this->set(DcsEntry, 0x3C, 0x3F, Collect, DcsParam);
+            this->set(DcsEntry, 0x40, 0x7E, Ignore, DcsPassthrough);
+
+            this->set(DcsParam, 0x20, 0x2F, Collect, DcsIntermediate);
+            this->set(DcsParam, 0x30, 0x39, Param, DcsParam);
+            this->set(DcsParam, 0x3A, 0x3A, Ignore, DcsIgnore);
+            this->set(DcsParam, 0x3B, 0x3B, Param, DcsParam);
+            this->set(DcsParam, 0x3C, 0x3F, Ignore, DcsIgnore);
+            this->set(DcsParam, 0x40, 0x7E, Ignore, DcsPassthrough);
+
+            this->set(DcsIntermediate, 0x20, 0x2F, Collect, DcsIntermediate);
+            this->set(DcsIntermediate, 0x30, 0x3F, Ignore, DcsIgnore);
+            this->set(DcsIntermediate, 0x40, 0x7E, Ignore, DcsPassthrough);
+        }
+    };
+
+    static const Table& table() {
+        static const Table table;
+        return table;
+    }
+
+    State state_ = Ground;
+    uint16_t params_[MAX_PARAMS];
+    unsigned char param_count_ = 0;
+    // private markers and intermediate bytes, only the first one is kept
+    char collected_ = 0;
+    unsigned char collected_count_ = 0;
+    // the byte after ESC which started the current sequence
+    char intro_ = 0;
+    // nothing arrived since `intro_`
+    bool untouched_ = false;
+    // ESC ended a string, so a '\\' (ST) is coming
+    bool string_ended_ = false;
+    // continuation bytes of the current utf-8 sequence still to come
+    unsigned char utf8_left_ = 0;
+    // the range the next continuation byte has to be in, narrower after some leads (no overlongs or surrogates)
+    unsigned char utf8_lower_ = 0x80;
+    unsigned char utf8_upper_ = 0xBF;
+    uint32_t utf8_codepoint_ = 0;
+    // Alt+<character> is ESC <character>
+    unsigned char utf8_mods_ = 0;
+    // between `CSI 200~` and `CSI 201~`
+    bool in_paste_ = false;
+    // where the paste started in the buffer being fed, `nullptr` once it's been copied into `paste_`
+    const char* paste_from_ = nullptr;
+    // the paste so far, if it's split between buffers, keeps its capacity for the next one
+    std::string paste_;
+    // the number of bytes of `CSI 201~` matched so far, which aren't in `paste_`
+    unsigned char paste_end_ = 0;
+
+    // find the end of the paste (`CSI 201~`), with `memchr()` from one ESC to the next
+    // returns: true once it ended and is in `out`
+    bool paste(const char*& data, const char* end, Input& out) {
+        static const char END[] = "\x1B[201~";
+        const unsigned char END_LEN = sizeof(END) - 1;
+        // only copied if the buffer ends before the paste does
+        bool copy = (this->paste_from_ == nullptr);
+        while (data != end) {
+            if (this->paste_end_ == 0) {
+                const auto* esc = static_cast<const char*>(std::memchr(data, '\x1B', end - data));
+                const char* until = (esc != nullptr) ? esc : end;
+                if (copy) {
+                    this->paste_.append(data, until);
+                }
+                data = until;
+                if (esc == nullptr) {
+                    break;
+                }
+            }
+            if (*data != END[this->paste_end_]) {
+                // not the end after all, this byte is looked at again
+                if (copy) {
+                    this->paste_.append(END, this->paste_end_);
+                }
+                this->paste_end_ = 0;
+                if (*data != '\x1B') {
+                    if (copy) {
+                        this->paste_ += *data;
+                    }
+                    ++data;
+                }
+                continue;
+            }
+            ++data;
+            if (++this->paste_end_ == END_LEN) {
+                if (copy) {
+                    out = Input(this->paste_.data(), this->paste_.size());
+                } else {
+                    out = Input(this->paste_from_, static_cast<size_t>(data - END_LEN - this->paste_from_));
+                }
+                this->paste_from_ = nullptr;
+                this->paste_end_ = 0;
+                this->in_paste_ = false;
+                return true;
+            }
+        }
+        if (!copy) {
+            // the part of `CSI 201~` already matched is added later, if it turns out not to be the end
+            this->paste_.assign(this->paste_from_, data - this->paste_end_);
+            this->paste_from_ = nullptr;
+        }
+        return false;
+    }
+
+    void clear() {
+        this->param_count_ = 0;
+        this->params_[0] = 0;
+        this->collected_ = 0;
+        this->collected_count_ = 0;
+    }
+
+    void param(unsigned char byte) {
+        if (this->param_count_ == 0) {
+            this->param_count_ = 1;
+        }
+        if (byte == ';' || byte == ':') {
+            if (this->param_count_ < MAX_PARAMS) {
+                this->params_[this->param_count_++] = 0;
+            }
+            return;
+        }
+        auto& param = this->params_[this->param_count_ - 1];
+        auto value = (param * 10U) + (byte - '0');
+        param = static_cast<uint16_t>(value > 0xFFFFU ? 0xFFFFU : value);
+    }
+
+    // the `ix`th parameter, `def` if it's missing or 0
+    unsigned param_or(unsigned ix, unsigned def) const {
+        return (ix < this->param_count_ && this->params_[ix] != 0) ? this->params_[ix] : def;
+    }
+
+    // `Mod`s encoded in the `ix`th parameter
+    unsigned char mods(unsigned ix) const { return static_cast<unsigned char>((this->param_or(ix, 1) - 1) & 0x0FU); }
+
+    // the keys that are the same with CSI and SS3
+    static bool key(unsigned char final, Input& out) {
+        switch (final) {
+        case Arrow::Up:
+        case Arrow::Down:
+        case Arrow::Right:
+        case Arrow::Left:
+            out = Input(static_cast<Arrow>(final));
+            return true;
+        case SpecKey::F1:
+        case SpecKey::F2:
+        case SpecKey::F3:
+        case SpecKey::F4:
+        case SpecKey::End:
+        case SpecKey::Home:
+        case SpecKey::ShiftTab:
+            out = Input(static_cast<SpecKey>(final));
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // the key of `CSI <n>~`
+    static bool tilde_key(unsigned n, Input& out) {
+        static const SpecKey KEYS[] = {
+            SpecKey::None,     SpecKey::Home,   SpecKey::Insert, SpecKey::Delete, SpecKey::End, // 0-4
+            SpecKey::PageUp,   SpecKey::PageDown, SpecKey::Home, SpecKey::End,    SpecKey::None, // 5-9
+            SpecKey::None,     SpecKey::F1,     SpecKey::F2,     SpecKey::F3,     SpecKey::F4,  // 10-14
+            SpecKey::F5,       SpecKey::None,   SpecKey::F6,     SpecKey::F7,     SpecKey::F8,  // 15-19
+            SpecKey::F9,       SpecKey::F10,    SpecKey::None,   SpecKey::F11,    SpecKey::F12, // 20-24
+        };
+        if (n >= sizeof(KEYS) / sizeof(KEYS[0]) || KEYS[n] == SpecKey::None) {
+            return false;
+        }
+        out = Input(KEYS[n]);
+        return true;
+    }
+
+    // SGR encoded mouse report: `CSI < <button>;<col>;<row> M` (or `m` on release)
+    bool mouse_dispatch(unsigned char final, Input& out) const {
+        auto code = this->param_or(0, 0);
+        Mouse mouse;
+        mouse.col = this->param_or(1, 1);
+        mouse.row = this->param_or(2, 1);
+        auto button = code & 0x03U;
+        if ((code & 0x40U) != 0) {
+            mouse.kind = Mouse::Kind::Wheel;
+            mouse.button = static_cast<Mouse::Button>(static_cast<unsigned>(Mouse::Button::WheelUp) + button);
+        } else if ((code & 0x80U) != 0) {
+            mouse.kind = (final == 'M') ? Mouse::Kind::Press : Mouse::Kind::Release;
+            mouse.button = (button == 0) ? Mouse::Button::Back : Mouse::Button::Forward;
+        } else {
+            mouse.button = static_cast<Mouse::Button>(button);
+            if ((code & 0x20U) != 0) {
+                mouse.kind = Mouse::Kind::Move;
+            } else {
+                mouse.kind = (final == 'M') ? Mouse::Kind::Press : Mouse::Kind::Release;
+            }
+        }
+        out = Input(mouse);
+        out.mods = static_cast<unsigned char>(((code & 0x04U) != 0 ? Mod::Shift : 0) |
+                                              ((code & 0x08U) != 0 ? Mod::Alt : 0) |
+                                              ((code & 0x10U) != 0 ? Mod::Ctrl : 0));
+        return true;
+    }
+
+    bool csi_dispatch(unsigned char final, Input& out) {
+        if (this->collected_count_ == 1 && this->collected_ == '<' && (final == 'M' || final == 'm')) {
+            return this->mouse_dispatch(final, out);
+        }
+        if (this->collected_count_ != 0) {
+            return false;
+        }
+        if (final == '~' && this->param_or(0, 0) == 200) {
+            this->in_paste_ = true;
+            this->paste_.clear();
+            return false;
+        }
+        if (final == '~') {
+            if (!InputParser::tilde_key(this->param_or(0, 0), out)) {
+                return false;
+            }
+        } else if (!InputParser::key(final, out)) {
+            return false;
+        }
+        out.mods = this->mods(1);
+        return true;
+    }
+
+    // `ESC O <mods><key>`
+    bool ss3_dispatch(unsigned char final, Input& out) const {
+        if (!InputParser::key(final, out)) {
+            return false;
+        }
+        out.mods = this->mods(0);
+        return true;
+    }
+
+    // Ctrl<char>, Tab, Enter, Backspace, ...
+    static bool execute(unsigned char byte, Input& out) {
+        if (byte >= 1 && byte <= 26) {
+            out = Input(static_cast<SpecKey>(byte));
+            return true;
+        }
+        if (byte == SpecKey::Backspace) {
+            out = Input(SpecKey::Backspace);
+            return true;
+        }
+        return false;
+    }
+
+    // start a utf-8 sequence with `lead`, the well-formed ones are in table 3-7 of the unicode standard
+    // returns: true if `lead` can't start one, `out` is U+FFFD then
+    bool utf8(unsigned char lead, Input& out) {
+        this->utf8_mods_ = (this->state_ == Escape) ? static_cast<unsigned char>(Mod::Alt) : 0;
+        this->utf8_lower_ = 0x80;
+        this->utf8_upper_ = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            this->utf8_left_ = 1;
+            this->utf8_codepoint_ = lead & 0x1FU;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            this->utf8_left_ = 2;
+            this->utf8_codepoint_ = lead & 0x0FU;
+            if (lead == 0xE0) {
+                this->utf8_lower_ = 0xA0;
+            } else if (lead == 0xED) {
+                this->utf8_upper_ = 0x9F;
+            }
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            this->utf8_left_ = 3;
+            this->utf8_codepoint_ = lead & 0x07U;
+            if (lead == 0xF0) {
+                this->utf8_lower_ = 0x90;
+            } else if (lead == 0xF4) {
+                this->utf8_upper_ = 0x8F;
+            }
+        } else {
+            this->utf8_invalid(out);
+            return true;
+        }
+        return false;
+    }
+
+    void utf8_invalid(Input& out) {
+        this->utf8_left_ = 0;
+        out = Input(static_cast<char32_t>(0xFFFD));
+        out.mods = this->utf8_mods_;
+    }
+
+    bool act(Action action, unsigned char byte, Input& out) {
+        switch (action) {
+        case Print:
+            out = Input(static_cast<char>(byte));
+            return true;
+        case Execute:
+            if (!InputParser::execute(byte, out)) {
+                return false;
+            }
+            if (this->state_ == Escape) {
+                out.mods |= Mod::Alt;
+            }
+            return true;
+        case Collect:
+            if (this->collected_count_++ == 0) {
+                this->collected_ = static_cast<char>(byte);
+            }
+            return false;
+        case Param:
+            this->param(byte);
+            return false;
+        case EscDispatch:
+            if (this->state_ != Escape) {
+                return false;
+            }
+            if (this->string_ended_ && byte == '\\') {
+                return false;
+            }
+            if (!InputParser::execute(byte, out)) {
+                out = Input(static_cast<char>(byte));
+            }
+            out.mods |= Mod::Alt;
+            return true;
+        case CsiDispatch:
+            return this->csi_dispatch(byte, out);
+        case Ss3Dispatch:
+            return this->ss3_dispatch(byte, out);
+        case Utf8:
+            return this->utf8(byte, out);
+        case Ignore:
+        default:
+            return false;
+        }
+    }
+
+  public:
+    // decode bytes from `data` until an `Input` is complete, `data` is moved past the consumed ones
+    // returns: true if `out` was set, false if all of them were consumed without completing an `Input`
+    bool feed(const char*& data, const char* end, Input& out) {
+        const auto& table = InputParser::table();
+        while (data != end) {
+            if (this->in_paste_) {
+                if (this->paste(data, end, out)) {
+                    return true;
+                }
+                continue;
+            }
+            if (this->utf8_left_ != 0) {
+                auto cont = static_cast<unsigned char>(*data);
+                if (cont < this->utf8_lower_ || cont > this->utf8_upper_) {
+                    // ill-formed, `cont` is decoded again on its own
+                    this->utf8_invalid(out);
+                    return true;
+                }
+                ++data;
+                this->utf8_codepoint_ = (this->utf8_codepoint_ << 6U) | (cont & 0x3FU);
+                this->utf8_lower_ = 0x80;
+                this->utf8_upper_ = 0xBF;
+                if (--this->utf8_left_ == 0) {
+                    out = Input(static_cast<char32_t>(this->utf8_codepoint_));
+                    out.mods = this->utf8_mods_;
+                    return true;
+                }
+                continue;
+            }
+            auto byte = static_cast<unsigned char>(*data++);
+            auto entry = table.next[this->state_][byte];
+            auto action = static_cast<Action>(entry >> 4U);
+            auto next = static_cast<State>(entry & 0x0FU);
+
+            bool done = (action != Ignore && this->act(action, byte, out));
+            if (byte == SpecKey::Esc) {
+                // ESC ESC: the first one was just an Esc
+                if (this->state_ == Escape) {
+                    out = Input(SpecKey::Esc);
+                    done = true;
+                }
+                this->string_ended_ = (this->state_ == OscString || this->state_ == DcsPassthrough ||
+                                       this->state_ == DcsIgnore || this->state_ == SosPmApcString);
+            }
+            bool intro = (this->state_ == Escape && next != Ground && next != EscapeIntermediate);
+            this->untouched_ = intro;
+            if (intro) {
+                this->intro_ = static_cast<char>(byte);
+            }
+            if (next != this->state_ && (next == Escape || next == CsiEntry || next == Ss3 || next == DcsEntry)) {
+                this->clear();
+            }
+            this->state_ = next;
+            if (this->in_paste_) {
+                // just started
+                this->paste_from_ = data;
+            }
+            if (done) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // no sequence (or paste) has been started and not finished yet
+    bool idle() const { return (this->state_ == Ground && this->utf8_left_ == 0 && !this->in_paste_); }
+    // a paste is being collected, which doesn't time out like the other sequences
+    bool in_paste() const { return this->in_paste_; }
+
+    // give up on the unfinished sequence, eg. after the rest didn't arrive in time
+    // returns: true if it was an `Input` after all, like a lone Esc or Alt+[, in `out`
+    // NOTE: doesn't end a paste
+    bool flush(Input& out) {
+        if (this->in_paste_) {
+            return false;
+        }
+        bool done = false;
+        if (this->utf8_left_ != 0) {
+            // cut short
+            this->utf8_invalid(out);
+            done = true;
+        } else if (this->state_ == Escape) {
+            out = Input(SpecKey::Esc);
+            done = true;
+        } else if (this->untouched_) {
+            out = Input(this->intro_);
+            out.mods = Mod::Alt;
+            done = true;
+        }
+        this->state_ = Ground;
+        this->untouched_ = false;
+        this->utf8_left_ = 0;
+        return done;
+    }
+};
+
+#ifndef _WIN32
+// reads input in bulk: a single `read()` pulls up to `CAPACITY` bytes and every complete `Input` is decoded from them
+// before reading again. an incomplete sequence is kept by the `InputParser` until the rest arrives,
+// the terminal's mode isn't touched
+// bursts of mouse motion and wheel reports that arrived together are merged into one, see `coalesce()`
+class InputReader {
+  public:
+    static const size_t CAPACITY = 4096;
+    // how long to wait for the rest of an escape sequence, before deciding it was a lone Esc
+    static const int ESC_TIMEOUT_MS = 25;
+
+  private:
+    int fd_;
+    char buf_[CAPACITY];
+    // the bytes not decoded yet are [`begin_`;`end_`)
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    size_t reads_ = 0;
+    InputParser parser_;
+    // decoded while looking for more to `coalesce()` with, but it couldn't be
+    Input peeked_;
+    bool has_peeked_ = false;
+    bool coalesce_ = true;
+    // [`begin_`;`ascii_end_`) is printable ascii, decoded without going through the `InputParser`
+    size_t ascii_end_ = 0;
+
+    bool decode(Input& out, bool force) {
+        if (this->begin_ >= this->ascii_end_ && this->parser_.idle()) {
+            const char* from = this->buf_ + this->begin_;
+            this->ascii_end_ = this->begin_ + tui::unicode::printable_run(from, this->buf_ + this->end_);
+        }
+        if (this->begin_ < this->ascii_end_) {
+            out = Input(this->buf_[this->begin_++]);
+            return true;
+        }
+        const char* data = this->buf_ + this->begin_;
+        bool done = this->parser_.feed(data, this->buf_ + this->end_, out);
+        this->begin_ = static_cast<size_t>(data - this->buf_);
+        return (done || (force && this->parser_.flush(out)));
+    }
+
+    bool next_decoded(Input& out, bool force) {
+        if (this->has_peeked_) {
+            out = this->peeked_;
+            this->has_peeked_ = false;
+        } else if (!this->decode(out, force)) {
+            return false;
+        }
+        if (!this->coalesce_ || !out.is_mouse) {
+            return true;
+        }
+        // only what's already buffered, never waits for more
+        Input following;
+        while (this->decode(following, false)) {
+            if (!out.coalesce(following)) {
+                this->peeked_ = following;
+                this->has_peeked_ = true;
+                break;
+            }
+        }
+        return true;
+    }
+
+  public:
+    explicit InputReader(int fd = STDIN_FILENO) : fd_(fd) {}
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+
+    // bytes waiting to be decoded
+    size_t buffered() const { return this->end_ - this->begin_; }
+    // there are bytes waiting to be decoded, or the start of a sequence
+    // NOTE: not while collecting a paste, it can take however long it takes
+    bool pending() const {
+        return (this->has_peeked_ || this->buffered() != 0 || (!this->parser_.idle() && !this->parser_.in_paste()));
+    }
+    // the number of `read()` syscalls made
+    size_t reads() const { return this->reads_; }
+
+    // decode the next buffered `Input`
+    // `force`: decode even if it might be the start of something longer, eg. a lone Esc
+    // returns: false if there's no complete `Input` buffered
+    bool next(Input& out, bool force = false) {
+        // most of the time it's just a character typed, kept small enough to be inlined
+        if (this->begin_ < this->ascii_end_ && !this->has_peeked_) {
+            out = Input(this->buf_[this->begin_++]);
+            return true;
+        }
+        return this->next_decoded(out, force);
+    }
+
+    // merge mouse motion and wheel reports buffered together (`Input::coalesce()`), so a fast mouse produces one
+    // `Input` per read instead of hundreds, on by default
+    void coalesce(bool enable) { this->coalesce_ = enable; }
+
+    // a single `read()` into the buffer, waiting at most `timeout_ms` for input (forever if negative)
+    // returns: the number of bytes read, 0 on timeout or end of input, -1 on error
+    ssize_t fill(int timeout_ms = -1) {
+        // the unused tail, (at most a partial sequence) goes to the front
+        if (this->begin_ != 0) {
+            std::memmove(this->buf_, this->buf_ + this->begin_, this->buffered());
+            this->ascii_end_ = (this->ascii_end_ > this->begin_) ? this->ascii_end_ - this->begin_ : 0;
+            this->end_ -= this->begin_;
+            this->begin_ = 0;
+        }
+        if (timeout_ms >= 0) {
+            struct pollfd pfd{};
+            pfd.fd = this->fd_;
+            pfd.events = POLLIN;
+            auto ready = ::poll(&pfd, 1, timeout_ms);
+            if (ready <= 0) {
+                return ready;
+            }
+        }
+        ++this->reads_;
+        auto n = ::read(this->fd_, this->buf_ + this->end_, CAPACITY - this->end_);
+        if (n > 0) {
+            this->end_ += static_cast<size_t>(n);
+        }
+        return n;
+    }
+
+    // `fill()`, waiting until `deadline` at most, even if a signal (eg. SIGWINCH on a resize) interrupts the wait
+    ssize_t fill_until(std::chrono::steady_clock::time_point deadline) {
+        while (true) {
+            auto left = deadline - std::chrono::steady_clock::now();
+            // rounded up, so it doesn't give up early
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(left + std::chrono::milliseconds(1) -
+                                                                              std::chrono::nanoseconds(1))
+                          .count();
+            auto got = this->fill(ms > 0 ? static_cast<int>(ms) : 0);
+            if (got >= 0 || errno != EINTR) {
+                return got;
+            }
+        }
+    }
+
+    // the next `Input`, reading only if there's no complete one buffered
+    Input read() {
+        Input input;
+        while (!this->next(input)) {
+            // the rest of an incomplete sequence gets only a little time to arrive
+            bool pending = this->pending();
+            auto got = pending ? this->fill_until(std::chrono::steady_clock::now() +
+                                                  std::chrono::milliseconds(int{ESC_TIMEOUT_MS}))
+                               : this->fill();
+            if (got > 0) {
+                continue;
+            }
+            if (!pending || got < 0) {
+                // NOTE: a single returned variable, so it's constructed in place
+                input = Input(SpecKey::None);
+                break;
+            }
+            // a lone Esc or the like, unless the unfinished sequence was dropped
+            if (this->next(input, true)) {
+                break;
+            }
+        }
+        return input;
     }
 };
+#endif
+
+inline Input Input::read() {
+#ifdef _WIN32
+    return Input::read_helper(Input::read_ch);
+#else
+    static InputReader reader;
+    return reader.read();
+#endif
+}
 
 inline std::ostream& operator<<(std::ostream& os, const Input& inp) {
     if (inp.is_ch) {
-        os << "character: '" << inp.ch << "'";
+        os << "character: '" << inp.utf8() << "'";
     } else if (inp.is_arrow) {
         os << "arrow: " << inp.arrow;
     } else if (inp.is_special) {
         os << "special: " << inp.special;
+    } else if (inp.is_mouse) {
+        os << "mouse: " << inp.mouse;
+    } else if (inp.is_paste) {
+        os << "paste: " << inp.paste_size << " bytes";
     } else if (inp == Input()) {
         os << "unset";
     } else {
         os << "error: unknown input";
     }
+    if (inp.mods != 0) {
+        const char* sep = " (";
+        for (const auto& mod : {Mod::Ctrl, Mod::Alt, Mod::Shift, Mod::Meta}) {
+            if (inp.has(mod)) {
+                os << sep << mod;
+                sep = "+";
+            }
+        }
+        os << ")";
+    }
     return os;
 }
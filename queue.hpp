@@ -0,0 +1,243 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <err.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
+
+// NOTE: handing input from a reader thread to the render loop goes:
+// ```c++
+// tui::SpscQueue<Input> events(true);           // with a wakeup, so `wait()` can block
+//
+// // reader thread
+// events.push(Input::read());
+//
+// // render thread, once per frame
+// events.drain([](const Input& input) { ... });  // everything that arrived since the last frame
+// ```
+namespace tui {
+    // sharing a cache line between the indices would make the two threads invalidate each other's cache on every
+    // `push()`/`pop()`
+    constexpr size_t CACHE_LINE = 64;
+
+    // bounded, wait-free queue between exactly one producer thread and exactly one consumer thread
+    // `N` has to be a power of 2, `push()` fails instead of blocking when it's full
+    // optionally has a wakeup (eventfd on linux, pipe on other unix, event on windows), so the consumer can `wait()`
+    // while it's empty, or `watch()` its `fd()` in a `tui::EventLoop`
+    // WARN: `Input::paste` points into the reader's buffer, push `Input::paste_str()` if pastes are enabled
+    // WARN: before c++17 `new` doesn't respect the alignment, keep it static or on the stack
+    template <typename T, size_t N = 256> class SpscQueue {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "the capacity of `SpscQueue` has to be a power of 2");
+
+        // the consumer's line, next one to pop
+        alignas(CACHE_LINE) std::atomic<size_t> head_{0};
+        // last `tail_` seen by the consumer, so it only touches the producer's line when it seems empty
+        size_t tail_cache_ = 0;
+        // the consumer is (about to be) blocked in `wait()`
+        std::atomic<bool> waiting_{false};
+
+        // the producer's line, next one to push
+        alignas(CACHE_LINE) std::atomic<size_t> tail_{0};
+        // last `head_` seen by the producer, so it only touches the consumer's line when it seems full
+        size_t head_cache_ = 0;
+        bool wakeup_ = false;
+
+        alignas(CACHE_LINE) T slots_[N];
+
+        // how many times `wait()` checks before blocking
+        static constexpr unsigned SPINS = 256;
+
+#ifdef _WIN32
+        HANDLE event_ = nullptr;
+#else
+        // read and write end, the same for an eventfd
+        int fds_[2] = {-1, -1};
+#endif
+
+        // let a blocked `wait()` return
+        void notify() {
+#ifdef _WIN32
+            SetEvent(this->event_);
+#else
+            // full (`EAGAIN`) means it'll wake up anyway
+            const uint64_t one = 1;
+            auto wrote = ::write(this->fds_[1], &one, (this->fds_[0] == this->fds_[1]) ? sizeof(one) : 1);
+            (void)wrote;
+#endif
+        }
+
+        // reset the wakeup after it fired
+        void consume_notification() {
+#ifndef _WIN32
+            uint64_t buf[8];
+            while (::read(this->fds_[0], buf, sizeof(buf)) > 0) {
+            }
+#endif
+        }
+
+      public:
+        explicit SpscQueue(bool wakeup = false) : wakeup_(wakeup) {
+            if (!wakeup) {
+                return;
+            }
+#ifdef _WIN32
+            // auto-reset
+            this->event_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+            if (this->event_ == nullptr) {
+                this->wakeup_ = false;
+            }
+#elif defined(__linux__)
+            this->fds_[0] = this->fds_[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (this->fds_[0] == -1) {
+                err(1, "eventfd");
+            }
+#else
+            if (pipe(this->fds_) == -1) {
+                err(1, "pipe");
+            }
+            for (auto fd : this->fds_) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+#endif
+        }
+        ~SpscQueue() {
+#ifdef _WIN32
+            if (this->event_ != nullptr) {
+                CloseHandle(this->event_);
+            }
+#else
+            if (this->fds_[0] != -1) {
+                ::close(this->fds_[0]);
+            }
+            if (this->fds_[1] != this->fds_[0]) {
+                ::close(this->fds_[1]);
+            }
+#endif
+        }
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        static constexpr size_t capacity() { return N; }
+
+        // producer only
+        // returns: false if it's full, `value` is dropped then
+        bool push(const T& value) {
+            auto tail = this->tail_.load(std::memory_order_relaxed);
+            if (tail - this->head_cache_ == N) {
+                this->head_cache_ = this->head_.load(std::memory_order_acquire);
+                if (tail - this->head_cache_ == N) {
+                    return false;
+                }
+            }
+            this->slots_[tail & (N - 1)] = value;
+            this->tail_.store(tail + 1, std::memory_order_release);
+
+            if (this->wakeup_) {
+                // pairs with the one in `wait()`: either it sees the new `tail_`, or we see `waiting_`
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (this->waiting_.load(std::memory_order_relaxed)) {
+                    this->notify();
+                }
+            }
+            return true;
+        }
+
+        // consumer only
+        // returns: false if it's empty, `out` is untouched then
+        bool pop(T& out) {
+            auto head = this->head_.load(std::memory_order_relaxed);
+            if (head == this->tail_cache_) {
+                this->tail_cache_ = this->tail_.load(std::memory_order_acquire);
+                if (head == this->tail_cache_) {
+                    return false;
+                }
+            }
+            out = this->slots_[head & (N - 1)];
+            this->head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer only, call `fn(const T&)` on everything pushed so far, at most `max` of them
+        // cheaper than `pop()`-ing them one by one: the indices are only synchronized once
+        // returns: the number of values drained
+        template <typename Fn> size_t drain(Fn fn, size_t max = N) {
+            auto head = this->head_.load(std::memory_order_relaxed);
+            this->tail_cache_ = this->tail_.load(std::memory_order_acquire);
+            auto count = this->tail_cache_ - head;
+            if (count > max) {
+                count = max;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                fn(static_cast<const T&>(this->slots_[(head + i) & (N - 1)]));
+            }
+            this->head_.store(head + count, std::memory_order_release);
+            return count;
+        }
+
+        // consumer only, a snapshot which might be outdated by the time it returns
+        bool empty() const {
+            return this->head_.load(std::memory_order_relaxed) == this->tail_.load(std::memory_order_acquire);
+        }
+
+        // consumer only, block until something's pushed or `timeout_ms` passes, `-1` means no timeout
+        // WARN: needs the wakeup, otherwise it can only check once
+        // returns: whether it's not `empty()`
+        bool wait(int timeout_ms = -1) {
+            // a burst is likely to go on, cheaper to spin a bit than to go to sleep and get woken up
+            for (unsigned spin = 0; spin < SPINS; ++spin) {
+                if (!this->empty()) {
+                    return true;
+                }
+            }
+            if (!this->wakeup_) {
+                return false;
+            }
+            this->waiting_.store(true, std::memory_order_relaxed);
+            // pairs with the one in `push()`
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->empty()) {
+#ifdef _WIN32
+                WaitForSingleObject(this->event_, (timeout_ms < 0) ? INFINITE : static_cast<DWORD>(timeout_ms));
+#else
+                pollfd pfd{this->fds_[0], POLLIN, 0};
+                if (poll(&pfd, 1, timeout_ms) == -1 && errno != EINTR) {
+                    err(1, "poll");
+                }
+#endif
+            }
+            this->waiting_.store(false, std::memory_order_relaxed);
+            this->consume_notification();
+            return !this->empty();
+        }
+
+        // readable when something was pushed while the consumer was `waiting()`, -1 without a wakeup or on windows
+        // INFO: set `waiting(true)` before `poll()`-ing it, check `empty()` after that, `waiting(false)` when woken
+        int fd() const {
+#ifdef _WIN32
+            return -1;
+#else
+            return this->fds_[0];
+#endif
+        }
+        void waiting(bool waiting) {
+            this->waiting_.store(waiting, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!waiting) {
+                this->consume_notification();
+            }
+        }
+    };
+} // namespace tui
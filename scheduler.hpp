@@ -0,0 +1,250 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <cerrno>
+#include <ctime>
+#endif
+
+// NOTE: a game loop with a fixed simulation rate and capped, on-demand rendering goes:
+// ```c++
+// tui::FrameScheduler sched(std::chrono::milliseconds(50), 60); // 20 ticks/s, at most 60 fps
+// while (running) {
+//     sched.wait();                                    // sleeps until a tick or a frame is due
+//     for (auto n = sched.due_ticks(); n > 0; --n) {
+//         update();
+//         sched.mark_dirty();
+//     }
+//     if (sched.begin_frame()) {                       // only if something changed since the last one
+//         draw();
+//         std::cout.flush();
+//         sched.end_frame();
+//     }
+// }
+// ```
+// with other things to wait for, use `timeout_ms()` instead of `wait()`, eg. `loop.wait_event(sched.timeout_ms())`
+namespace tui {
+    // separates simulation ticks, which happen at a fixed rate, from render frames, which happen only when
+    // something's `mark_dirty()`-ed, at most `max_fps` times a second
+    // every deadline is absolute, so late wakeups don't add up to drift
+    class FrameScheduler {
+      public:
+        using clock = std::chrono::steady_clock;
+
+        struct Stats {
+            uint64_t ticks = 0;
+            // ticks dropped because the simulation fell too far behind
+            uint64_t skipped_ticks = 0;
+            uint64_t frames = 0;
+            // between `begin_frame()` and `end_frame()`
+            clock::duration last_frame_time{0};
+            clock::duration max_frame_time{0};
+            clock::duration total_frame_time{0};
+            // how late `wait()` woke up compared to the deadline
+            clock::duration max_jitter{0};
+            clock::duration total_jitter{0};
+            uint64_t wakeups = 0;
+
+            clock::duration avg_frame_time() const {
+                if (this->frames == 0) {
+                    return clock::duration{0};
+                }
+                return this->total_frame_time / static_cast<clock::rep>(this->frames);
+            }
+            clock::duration avg_jitter() const {
+                if (this->wakeups == 0) {
+                    return clock::duration{0};
+                }
+                return this->total_jitter / static_cast<clock::rep>(this->wakeups);
+            }
+        };
+
+        // at most this many ticks are caught up in one `due_ticks()`, the rest are skipped,
+        // so a slow update can't make the simulation fall further and further behind
+        static const unsigned MAX_CATCH_UP = 5;
+
+      private:
+        // zero if there are no ticks
+        clock::duration tick_;
+        // shortest time between two frames, zero if not capped
+        clock::duration frame_;
+        clock::time_point next_tick_;
+        clock::time_point next_frame_;
+        clock::time_point frame_start_;
+        std::atomic<bool> dirty_{true};
+        Stats stats_;
+
+        // `wait()` blocks on these while nothing is dirty, so `mark_dirty()` from another thread can wake it
+        std::mutex mutex_;
+        std::condition_variable idle_;
+        std::atomic<bool> idling_{false};
+
+        // sleep until the absolute `deadline`
+        static void sleep_until(clock::time_point deadline) {
+#ifdef __linux__
+            // `steady_clock` is `CLOCK_MONOTONIC` on linux
+            auto since = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+            timespec ts{};
+            ts.tv_sec = static_cast<time_t>(since / 1000000000);
+            ts.tv_nsec = static_cast<long>(since % 1000000000);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+            }
+#else
+            std::this_thread::sleep_until(deadline);
+#endif
+        }
+
+        // woke up for the `deadline`, count how late
+        void woke(clock::time_point deadline) {
+            auto late = clock::now() - deadline;
+            this->stats_.total_jitter += late;
+            if (late > this->stats_.max_jitter) {
+                this->stats_.max_jitter = late;
+            }
+            ++this->stats_.wakeups;
+        }
+
+      public:
+        // `tick` of zero means no simulation ticks, `max_fps` of zero means no cap
+        explicit FrameScheduler(clock::duration tick = clock::duration::zero(), unsigned max_fps = 60)
+            : tick_(tick),
+              frame_((max_fps == 0) ? clock::duration::zero() : clock::duration(std::chrono::seconds(1)) / max_fps) {
+            auto now = clock::now();
+            this->next_tick_ = now + tick;
+            this->next_frame_ = now;
+        }
+
+        // change the time between ticks, starting from the last one, eg. to speed up the game
+        void set_tick(clock::duration tick) {
+            this->next_tick_ += tick - this->tick_;
+            this->tick_ = tick;
+        }
+        clock::duration tick() const { return this->tick_; }
+
+        // something changed, a frame should be drawn, can be called from any thread
+        void mark_dirty() {
+            this->dirty_.store(true, std::memory_order_release);
+            // pairs with the one in `wait()`: either it sees `dirty_`, or we see `idling_`
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->idling_.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                this->idle_.notify_one();
+            }
+        }
+        bool dirty() const { return this->dirty_.load(std::memory_order_acquire); }
+
+        // when the next tick or frame is due, `clock::time_point::max()` if idle: no ticks and nothing dirty
+        clock::time_point deadline() const {
+            auto deadline = clock::time_point::max();
+            if (this->tick_ != clock::duration::zero()) {
+                deadline = this->next_tick_;
+            }
+            if (this->dirty() && this->next_frame_ < deadline) {
+                deadline = this->next_frame_;
+            }
+            return deadline;
+        }
+
+        // time until the `deadline()` in ms, rounded up, for `poll()` and friends
+        // returns: `idle_ms` if idle, which is -1 (forever) by default
+        int timeout_ms(int idle_ms = -1) const {
+            auto deadline = this->deadline();
+            if (deadline == clock::time_point::max()) {
+                return idle_ms;
+            }
+            auto now = clock::now();
+            if (deadline <= now) {
+                return 0;
+            }
+            // rounded up, waking up early would mean another round of waiting
+            auto left = deadline - now + std::chrono::milliseconds(1) - clock::duration(1);
+            return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(left).count());
+        }
+
+        // block until the next tick or frame is due, without using any cpu
+        // while nothing is dirty a `mark_dirty()` wakes it too, as the next frame might be due before the next tick
+        void wait() {
+            auto deadline = this->deadline();
+            if (!this->dirty()) {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                this->idling_.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto dirty = [this] { return this->dirty(); };
+                bool woken = true;
+                if (deadline == clock::time_point::max()) {
+                    this->idle_.wait(lock, dirty);
+                } else {
+                    woken = this->idle_.wait_until(lock, deadline, dirty);
+                }
+                this->idling_.store(false, std::memory_order_relaxed);
+                if (!woken) {
+                    this->woke(deadline);
+                    return;
+                }
+                deadline = this->deadline();
+            }
+            if (deadline <= clock::now()) {
+                return;
+            }
+            // already dirty, nothing can bring the deadline forward anymore
+            FrameScheduler::sleep_until(deadline);
+            this->woke(deadline);
+        }
+
+        // returns: how many ticks are due by now, advances the schedule past them
+        unsigned due_ticks() {
+            if (this->tick_ == clock::duration::zero()) {
+                return 0;
+            }
+            auto now = clock::now();
+            if (now < this->next_tick_) {
+                return 0;
+            }
+            auto due = static_cast<uint64_t>((now - this->next_tick_) / this->tick_) + 1;
+            // stay on the original grid, so late ticks don't shift the following ones
+            this->next_tick_ += this->tick_ * static_cast<clock::rep>(due);
+            unsigned run = (due > MAX_CATCH_UP) ? unsigned{MAX_CATCH_UP} : static_cast<unsigned>(due);
+            this->stats_.skipped_ticks += due - run;
+            this->stats_.ticks += run;
+            return run;
+        }
+
+        // returns: whether a frame should be drawn now: something is dirty and the fps cap allows it
+        // if so, the dirty flag is cleared, call `end_frame()` when done drawing
+        bool begin_frame() {
+            if (!this->dirty()) {
+                return false;
+            }
+            auto now = clock::now();
+            if (now < this->next_frame_) {
+                return false;
+            }
+            this->dirty_.store(false, std::memory_order_relaxed);
+            this->frame_start_ = now;
+            // keep to the grid as long as we keep up, otherwise start over from now
+            this->next_frame_ += this->frame_;
+            if (this->next_frame_ < now) {
+                this->next_frame_ = now + this->frame_;
+            }
+            return true;
+        }
+        void end_frame() {
+            auto took = clock::now() - this->frame_start_;
+            this->stats_.last_frame_time = took;
+            this->stats_.total_frame_time += took;
+            if (took > this->stats_.max_frame_time) {
+                this->stats_.max_frame_time = took;
+            }
+            ++this->stats_.frames;
+        }
+
+        const Stats& stats() const { return this->stats_; }
+        void reset_stats() { this->stats_ = Stats{}; }
+    };
+} // namespace tui
@@ -0,0 +1,443 @@
+#pragma once
+
+#include "tui.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// NOTE: finding out what the terminal has, instead of assuming xterm, goes:
+// ```c++
+// const auto& info = tui::terminfo();                   // the entry of `$TERM`, read once
+// if (info.has(tui::Terminfo::String::change_scroll_region)) { ... }
+// if (info.has("RGB")) { ... }                          // extended capabilities by name
+// tui::apply_terminfo();                                // the output arena uses what the terminal has
+// ```
+namespace tui {
+    // the compiled terminfo entry of a terminal (see term(5)), `mmap()`-ed and read in place, both the legacy and
+    // the extended number format (32 bit numbers, ncurses 6.1+) with the extended capabilities (eg. `RGB`, `Sync`)
+    // the predefined capabilities are looked up by their position, the extended ones by name in an index built once
+    // WARN: there's no terminfo on windows, nothing is ever `found()` there
+    class Terminfo {
+      public:
+        // the value of each is its position in the compiled entry, the same as in term.h
+        enum class Flag : std::uint16_t {
+            auto_right_margin = 1,
+            eat_newline_glitch = 4,
+            back_color_erase = 28,
+        };
+        enum class Number : std::uint16_t {
+            columns = 0,
+            lines = 2,
+            max_colors = 13,
+        };
+        enum class String : std::uint16_t {
+            carriage_return = 2,
+            change_scroll_region = 3,
+            clear_screen = 5,
+            clr_eol = 6,
+            column_address = 8,
+            cursor_address = 10,
+            cursor_down = 11,
+            cursor_home = 12,
+            cursor_invisible = 13,
+            cursor_left = 14,
+            cursor_normal = 16,
+            cursor_right = 17,
+            cursor_up = 19,
+            enter_ca_mode = 28,
+            erase_chars = 37,
+            exit_attribute_mode = 39,
+            exit_ca_mode = 40,
+            parm_down_cursor = 107,
+            parm_index = 109,
+            parm_left_cursor = 111,
+            parm_right_cursor = 112,
+            parm_rindex = 113,
+            parm_up_cursor = 114,
+            repeat_char = 121,
+            row_address = 127,
+            scroll_forward = 129,
+            scroll_reverse = 130,
+        };
+
+      private:
+        // 16 bit numbers, and 32 bit ones
+        static const std::uint16_t MAGIC_LEGACY = 0432;
+        static const std::uint16_t MAGIC_32BIT = 01036;
+        // anything bigger is not an entry
+        static const size_t MAX_SIZE = 1 << 20;
+
+        struct Extended {
+            enum class Kind : std::uint8_t { Flag, Number, String };
+            Kind kind;
+            int number;
+            // `nullptr` unless `Kind::String`
+            const char* string;
+        };
+
+        const unsigned char* data_ = nullptr;
+        size_t size_ = 0;
+        const char* names_ = nullptr;
+        // the sections of the predefined capabilities
+        const unsigned char* flags_ = nullptr;
+        size_t flag_count_ = 0;
+        const unsigned char* numbers_ = nullptr;
+        size_t number_count_ = 0;
+        // 2 or 4 bytes
+        size_t number_size_ = 2;
+        const unsigned char* offsets_ = nullptr;
+        size_t string_count_ = 0;
+        const char* table_ = nullptr;
+        size_t table_size_ = 0;
+        std::unordered_map<std::string, Extended> extended_;
+
+        // little endian, signed
+        static int read16(const unsigned char* at) { return static_cast<std::int16_t>(at[0] | (at[1] << 8U)); }
+        static int read32(const unsigned char* at) {
+            std::uint32_t value = at[0];
+            for (unsigned i = 1; i < 4; ++i) {
+                value |= static_cast<std::uint32_t>(at[i]) << (8U * i);
+            }
+            return static_cast<std::int32_t>(value);
+        }
+        int read_number(const unsigned char* at) const {
+            return (this->number_size_ == 4) ? Terminfo::read32(at) : Terminfo::read16(at);
+        }
+        // the string at `offset` in `table`, `nullptr` if it's absent (-1), cancelled (-2) or not in the table
+        static const char* string_at(const char* table, size_t size, int offset) {
+            if (offset < 0 || static_cast<size_t>(offset) >= size ||
+                std::memchr(table + offset, '\0', size - static_cast<size_t>(offset)) == nullptr) {
+                return nullptr;
+            }
+            return table + offset;
+        }
+
+        // open the compiled entry of `name`: in `$TERMINFO`, `~/.terminfo`, `$TERMINFO_DIRS`, then the usual places
+        // each has a directory of the first letter of the names, or its hex code on macos
+        // returns: the file descriptor, -1 if there's none
+        static int open_entry(const char* name) {
+#ifdef _WIN32
+            (void)name;
+            return -1;
+#else
+            // they'd lead outside the directories
+            if (name == nullptr || *name == '\0' || *name == '.' || std::strchr(name, '/') != nullptr) {
+                return -1;
+            }
+            std::string dirs;
+            if (const char* terminfo = std::getenv("TERMINFO")) {
+                dirs.append(terminfo).append(":");
+            }
+            if (const char* home = std::getenv("HOME")) {
+                dirs.append(home).append("/.terminfo:");
+            }
+            if (const char* terminfo_dirs = std::getenv("TERMINFO_DIRS")) {
+                dirs.append(terminfo_dirs).append(":");
+            }
+            dirs += "/etc/terminfo:/lib/terminfo:/usr/share/terminfo:/usr/lib/terminfo:/usr/local/share/terminfo";
+
+            static const char HEX[] = "0123456789abcdef";
+            const char letter[] = {name[0], '\0'};
+            const char hex[] = {HEX[static_cast<unsigned char>(name[0]) >> 4U],
+                                HEX[static_cast<unsigned char>(name[0]) & 15U], '\0'};
+            size_t from = 0;
+            while (from <= dirs.size()) {
+                auto to = dirs.find(':', from);
+                if (to == std::string::npos) {
+                    to = dirs.size();
+                }
+                // an empty one means the system's
+                auto dir = (to == from) ? std::string("/usr/share/terminfo") : dirs.substr(from, to - from);
+                for (const char* sub : {letter, hex}) {
+                    auto path = dir + "/" + sub + "/" + name;
+                    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                    if (fd != -1) {
+                        return fd;
+                    }
+                }
+                from = to + 1;
+            }
+            return -1;
+#endif
+        }
+
+        // find the sections, returns: false if it's not a compiled entry
+        bool parse() {
+            const auto* data = this->data_;
+            if (this->size_ < 12) {
+                return false;
+            }
+            auto magic = static_cast<std::uint16_t>(data[0] | (data[1] << 8U));
+            if (magic != MAGIC_LEGACY && magic != MAGIC_32BIT) {
+                return false;
+            }
+            this->number_size_ = (magic == MAGIC_32BIT) ? 4 : 2;
+            int header[5];
+            for (size_t i = 0; i < 5; ++i) {
+                header[i] = Terminfo::read16(data + 2 + (i * 2));
+                if (header[i] < 0) {
+                    return false;
+                }
+            }
+            size_t at = 12;
+            this->names_ = reinterpret_cast<const char*>(data + at);
+            at += static_cast<size_t>(header[0]);
+            this->flags_ = data + at;
+            this->flag_count_ = static_cast<size_t>(header[1]);
+            // numbers start on an even byte
+            at += this->flag_count_ + ((at + this->flag_count_) % 2);
+            this->numbers_ = data + at;
+            this->number_count_ = static_cast<size_t>(header[2]);
+            at += this->number_count_ * this->number_size_;
+            this->offsets_ = data + at;
+            this->string_count_ = static_cast<size_t>(header[3]);
+            at += this->string_count_ * 2;
+            this->table_ = reinterpret_cast<const char*>(data + at);
+            this->table_size_ = static_cast<size_t>(header[4]);
+            at += this->table_size_;
+            if (at > this->size_ || header[0] == 0 || this->names_[header[0] - 1] != '\0') {
+                return false;
+            }
+            this->parse_extended(at + (at % 2));
+            return true;
+        }
+
+        // index the extended capabilities starting at `at`, if there are any
+        void parse_extended(size_t at) {
+            const auto* data = this->data_;
+            if (at + 10 > this->size_) {
+                return;
+            }
+            int header[5];
+            for (size_t i = 0; i < 5; ++i) {
+                header[i] = Terminfo::read16(data + at + (i * 2));
+                if (header[i] < 0) {
+                    return;
+                }
+            }
+            at += 10;
+            auto flag_count = static_cast<size_t>(header[0]);
+            auto number_count = static_cast<size_t>(header[1]);
+            auto string_count = static_cast<size_t>(header[2]);
+            // `header[3]` only counts the strings present
+            auto table_size = static_cast<size_t>(header[4]);
+            auto name_count = flag_count + number_count + string_count;
+            // the offsets of the string values, then of every name
+            auto offset_count = string_count + name_count;
+            const auto* flags = data + at;
+            at += flag_count + ((at + flag_count) % 2);
+            const auto* numbers = data + at;
+            at += number_count * this->number_size_;
+            const auto* offsets = data + at;
+            at += offset_count * 2;
+            const auto* table = reinterpret_cast<const char*>(data + at);
+            if (at + table_size > this->size_) {
+                return;
+            }
+
+            // the names follow the last string value
+            size_t names_from = 0;
+            for (size_t i = 0; i < string_count; ++i) {
+                const auto* value = Terminfo::string_at(table, table_size, Terminfo::read16(offsets + (i * 2)));
+                if (value != nullptr) {
+                    names_from = std::max(names_from, static_cast<size_t>(value - table) + std::strlen(value) + 1);
+                }
+            }
+            if (names_from > table_size) {
+                return;
+            }
+            this->extended_.reserve(name_count);
+            for (size_t i = 0; i < name_count; ++i) {
+                const auto* name = Terminfo::string_at(table + names_from, table_size - names_from,
+                                                       Terminfo::read16(offsets + ((string_count + i) * 2)));
+                if (name == nullptr) {
+                    continue;
+                }
+                Extended cap{Extended::Kind::Flag, 0, nullptr};
+                if (i < flag_count) {
+                    cap.number = (flags[i] == 1) ? 1 : -1;
+                } else if (i < flag_count + number_count) {
+                    cap.kind = Extended::Kind::Number;
+                    cap.number = this->read_number(numbers + ((i - flag_count) * this->number_size_));
+                } else {
+                    cap.kind = Extended::Kind::String;
+                    auto offset = Terminfo::read16(offsets + ((i - flag_count - number_count) * 2));
+                    cap.string = Terminfo::string_at(table, table_size, offset);
+                    cap.number = (cap.string == nullptr) ? -1 : 0;
+                }
+                this->extended_.emplace(name, cap);
+            }
+        }
+
+        void unmap() {
+#ifndef _WIN32
+            if (this->data_ != nullptr) {
+                ::munmap(const_cast<unsigned char*>(this->data_), this->size_);
+            }
+#endif
+            this->data_ = nullptr;
+            this->size_ = 0;
+            this->extended_.clear();
+        }
+
+      public:
+        Terminfo() = default;
+        // the entry of the terminal called `name`, eg. "xterm-256color", not `found()` if there's none
+        explicit Terminfo(const char* name) {
+#ifndef _WIN32
+            auto fd = Terminfo::open_entry(name);
+            if (fd == -1) {
+                return;
+            }
+            struct stat st{};
+            if (::fstat(fd, &st) == 0 && st.st_size > 0 && static_cast<size_t>(st.st_size) <= MAX_SIZE) {
+                auto size = static_cast<size_t>(st.st_size);
+                auto* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                    this->data_ = static_cast<const unsigned char*>(data);
+                    this->size_ = size;
+                }
+            }
+            ::close(fd);
+            if (this->data_ != nullptr && !this->parse()) {
+                this->unmap();
+            }
+#else
+            (void)name;
+#endif
+        }
+        ~Terminfo() { this->unmap(); }
+        Terminfo(const Terminfo&) = delete;
+        Terminfo& operator=(const Terminfo&) = delete;
+        Terminfo(Terminfo&& other) noexcept { *this = std::move(other); }
+        Terminfo& operator=(Terminfo&& other) noexcept {
+            if (this != &other) {
+                this->unmap();
+                this->data_ = other.data_;
+                this->size_ = other.size_;
+                this->names_ = other.names_;
+                this->flags_ = other.flags_;
+                this->flag_count_ = other.flag_count_;
+                this->numbers_ = other.numbers_;
+                this->number_count_ = other.number_count_;
+                this->number_size_ = other.number_size_;
+                this->offsets_ = other.offsets_;
+                this->string_count_ = other.string_count_;
+                this->table_ = other.table_;
+                this->table_size_ = other.table_size_;
+                this->extended_ = std::move(other.extended_);
+                other.data_ = nullptr;
+                other.size_ = 0;
+                other.extended_.clear();
+            }
+            return *this;
+        }
+
+        bool found() const { return this->data_ != nullptr; }
+        // the names of the terminal separated by '|', the last one describes it, "" if not `found()`
+        const char* names() const { return this->found() ? this->names_ : ""; }
+
+        bool flag(Flag cap) const {
+            auto ix = static_cast<size_t>(cap);
+            return this->found() && ix < this->flag_count_ && this->flags_[ix] == 1;
+        }
+        // returns: -1 if it doesn't have it
+        int number(Number cap) const {
+            auto ix = static_cast<size_t>(cap);
+            if (!this->found() || ix >= this->number_count_) {
+                return -1;
+            }
+            auto value = this->read_number(this->numbers_ + (ix * this->number_size_));
+            return (value < 0) ? -1 : value;
+        }
+        // the sequence with its parameters (`%p1%d`, ...) as they are, see terminfo(5)
+        // returns: `nullptr` if it doesn't have it
+        const char* string(String cap) const {
+            auto ix = static_cast<size_t>(cap);
+            if (!this->found() || ix >= this->string_count_) {
+                return nullptr;
+            }
+            return Terminfo::string_at(this->table_, this->table_size_, Terminfo::read16(this->offsets_ + (ix * 2)));
+        }
+        bool has(String cap) const { return this->string(cap) != nullptr; }
+
+        // the extended capabilities, by name
+        bool flag(const std::string& name) const {
+            auto found = this->extended_.find(name);
+            return found != this->extended_.end() && found->second.kind == Extended::Kind::Flag &&
+                   found->second.number == 1;
+        }
+        int number(const std::string& name) const {
+            auto found = this->extended_.find(name);
+            return (found != this->extended_.end() && found->second.kind == Extended::Kind::Number &&
+                    found->second.number >= 0)
+                       ? found->second.number
+                       : -1;
+        }
+        const char* string(const std::string& name) const {
+            auto found = this->extended_.find(name);
+            return (found != this->extended_.end()) ? found->second.string : nullptr;
+        }
+        // whether it has the extended capability `name` of any kind, eg. `RGB` is a flag, a number or a string
+        bool has(const std::string& name) const {
+            auto found = this->extended_.find(name);
+            return found != this->extended_.end() && found->second.number >= 0 &&
+                   (found->second.kind != Extended::Kind::Flag || found->second.number == 1);
+        }
+    };
+
+    // the entry of `$TERM`, read on the first call
+    inline const Terminfo& terminfo() {
+        static const Terminfo info(std::getenv("TERM"));
+        return info;
+    }
+
+    // make the output arena use what the terminal has, instead of what xterm has:
+    // - `Output::runs()`: REP if it has `rep`, ECH if it has `ech` and `bce`, as `Output` writes them
+    // - `Output::synchronized()`: if it has `Sync` (mode 2026)
+    // - `color_depth()`: rgb with `RGB` or `Tc`, otherwise from `colors`, unless it's already more
+    // it only turns things on, so the queries asking the terminal itself (`supports_*()`) can come before or after
+    // INFO: the scroll region, used by `Frame::detect_scroll()`, is `has(Terminfo::String::change_scroll_region)`
+    inline void apply_terminfo(const Terminfo& info = terminfo()) {
+        if (!info.found()) {
+            return;
+        }
+        using String = Terminfo::String;
+        const char* rep = info.string(String::repeat_char);
+        const char* ech = info.string(String::erase_chars);
+        if (rep != nullptr && std::strcmp(rep, "%p1%c\x1B[%p2%{1}%-%db") == 0) {
+            output().runs(RunEncoding::Repeat);
+        } else if (ech != nullptr && std::strcmp(ech, "\x1B[%p1%dX") == 0 &&
+                   info.flag(Terminfo::Flag::back_color_erase) && output().runs() == RunEncoding::Literal) {
+            output().runs(RunEncoding::Erase);
+        }
+
+        const char* sync = info.string("Sync");
+        if (sync != nullptr && std::strstr(sync, "\x1B[?2026") != nullptr) {
+            output().synchronized(true);
+        }
+
+        auto depth = ColorDepth::Basic;
+        auto colors = info.number(Terminfo::Number::max_colors);
+        if (info.has("RGB") || info.flag("Tc") || colors >= (1 << 24)) {
+            depth = ColorDepth::Rgb;
+        } else if (colors >= 256) {
+            depth = ColorDepth::Indexed;
+        }
+        if (depth > color_depth().load()) {
+            color_depth() = depth;
+        }
+    }
+} // namespace tui
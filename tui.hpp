@@ -10,18 +10,30 @@
 #include <csignal>
 #include <err.h>       // err
 #include <fcntl.h>     // open
+#include <poll.h>      // poll
 #include <sys/ioctl.h> // ioctl, TIOCGWINSZ
 #include <termios.h>
-#include <unistd.h> // close
+#include <unistd.h> // close, write
 
 #endif
 
+#include <algorithm> // search, min
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib> // getenv
+#include <cstring> // memcpy
 #include <iostream>
 #include <sstream>
+#include <streambuf>
 #include <string>
 #include <utility> // for std::pair
+#include <vector>
+
+#include "unicode.hpp"
 
 namespace tui {
     // only the Esc character
@@ -37,17 +49,121 @@ namespace tui {
         return oss.str();
     }
 
+    // allocation-free encoding of escape sequences into a caller provided buffer
+    // every function writes at `out` and returns the position right after the last written byte
+    // NOTE: `out` has to have room for at least `MAX_SEQ` bytes
+    namespace encode {
+        // the longest sequence any of these functions (or `Style::encode()`) writes
+        constexpr const size_t MAX_SEQ = 64;
+
+        // two decimal digits for each of [0;99]: "00", "01", ..., "99"
+        constexpr const char DIGIT_PAIRS[] = "0001020304050607080910111213141516171819"
+                                             "2021222324252627282930313233343536373839"
+                                             "4041424344454647484950515253545556575859"
+                                             "6061626364656667686970717273747576777879"
+                                             "8081828384858687888990919293949596979899";
+
+        constexpr const char PREFIX_CSI[] = "\x1B[";
+        constexpr const char PREFIX_FG_RGB[] = "\x1B[38;2;";
+        constexpr const char PREFIX_BG_RGB[] = "\x1B[48;2;";
+        constexpr const char PREFIX_FG_256[] = "\x1B[38;5;";
+        constexpr const char PREFIX_BG_256[] = "\x1B[48;5;";
+
+        // copy a string literal, without its '\0'
+        template <size_t N> char* literal(char* out, const char (&lit)[N]) {
+            std::memcpy(out, lit, N - 1);
+            return out + N - 1;
+        }
+
+        // decimal digits of `n`, two at a time
+        inline char* uint(char* out, unsigned n) {
+            char tmp[10];
+            char* end = tmp + sizeof(tmp);
+            char* digits = end;
+            while (n >= 100) {
+                auto ix = (n % 100) * 2;
+                n /= 100;
+                *--digits = DIGIT_PAIRS[ix + 1];
+                *--digits = DIGIT_PAIRS[ix];
+            }
+            if (n >= 10) {
+                *--digits = DIGIT_PAIRS[(n * 2) + 1];
+                *--digits = DIGIT_PAIRS[n * 2];
+            } else {
+                *--digits = static_cast<char>('0' + n);
+            }
+            std::memcpy(out, digits, static_cast<size_t>(end - digits));
+            return out + (end - digits);
+        }
+
+        // CSI `n` `final`, eg.: "ESC[3A" for `cursor_move(out, 3, 'A')`
+        inline char* csi_n(char* out, unsigned n, char final) {
+            out = uint(literal(out, PREFIX_CSI), n);
+            *out++ = final;
+            return out;
+        }
+
+        // CSI `row`;`col` H
+        inline char* cursor_position(char* out, unsigned row, unsigned col) {
+            out = uint(literal(out, PREFIX_CSI), row);
+            *out++ = ';';
+            out = uint(out, col);
+            *out++ = 'H';
+            return out;
+        }
+
+        // CSI `top`;`bottom` r
+        inline char* scroll_region(char* out, unsigned top, unsigned bottom) {
+            out = uint(literal(out, PREFIX_CSI), top);
+            *out++ = ';';
+            out = uint(out, bottom);
+            *out++ = 'r';
+            return out;
+        }
+
+        // CSI `code` m
+        inline char* sgr(char* out, unsigned code) { return csi_n(out, code, 'm'); }
+
+        // CSI 38;5;`ix` m or CSI 48;5;`ix` m
+        inline char* indexed(char* out, unsigned ix, bool fg) {
+            out = uint(fg ? literal(out, PREFIX_FG_256) : literal(out, PREFIX_BG_256), ix);
+            *out++ = 'm';
+            return out;
+        }
+
+        // CSI 38;2;`r`;`g`;`b` m or CSI 48;2;`r`;`g`;`b` m
+        inline char* rgb(char* out, unsigned r, unsigned g, unsigned b, bool fg) {
+            out = uint(fg ? literal(out, PREFIX_FG_RGB) : literal(out, PREFIX_BG_RGB), r);
+            *out++ = ';';
+            out = uint(out, g);
+            *out++ = ';';
+            out = uint(out, b);
+            *out++ = 'm';
+            return out;
+        }
+    } // namespace encode
+
+    // write the bytes in [`begin`;`end`) to `std::cout`
+    inline void put(const char* begin, const char* end) { std::cout.write(begin, end - begin); }
+
 // Control Sequence Introducer
 #define csi(...) std::cout << concat("\x1B[", __VA_ARGS__);
-// function using Control Sequence Introducer
-#define csi_fn(name, ...)                                                                                              \
-    inline void name() { csi(__VA_ARGS__) }
+// function using Control Sequence Introducer, `seq` has to be a string literal
+#define csi_fn(name, seq)                                                                                              \
+    inline void name() { std::cout << "\x1B[" seq; }
 
 // ANSII Escape Sequence
 #define esc(...) std::cout << concat("\x1B", __VA_ARGS__);
-// function using ANSII Escape Sequence
-#define esc_fn(name, ...)                                                                                              \
-    inline void name() { esc(__VA_ARGS__) }
+// function using ANSII Escape Sequence, `seq` has to be a string literal
+#define esc_fn(name, seq)                                                                                              \
+    inline void name() { std::cout << "\x1B" seq; }
+
+// function using Control Sequence Introducer with a numeric parameter, defaulting to `def`
+#define csi_n_fn(name, def, final)                                                                                     \
+    inline void name(unsigned n = def) {                                                                               \
+        char buf[encode::MAX_SEQ];                                                                                     \
+        put(buf, encode::csi_n(buf, n, final));                                                                        \
+    }
 
 #ifdef _WIN32 // windows
 // basic setup of windows terminal handling
@@ -64,6 +180,26 @@ namespace tui {
     }
 #endif
 
+#ifndef _WIN32
+    // what `enable_raw_mode()` and `init()` changed, so it can be undone, even from a signal handler
+    struct TermState {
+        // the attributes from before `enable_raw_mode()`
+        struct termios orig{};
+        struct termios raw{};
+        bool saved = false;
+        bool raw_enabled = false;
+        // set by `init()`
+        bool alt_screen = false;
+        bool cursor_visible = true;
+        // set by `suspend()` once continued
+        volatile std::sig_atomic_t resumed = 0;
+    };
+    inline TermState& term_state() {
+        static TermState state;
+        return state;
+    }
+#endif
+
     inline void enable_raw_mode() {
 #ifdef _WIN32 // windows
         win_setup();
@@ -76,21 +212,26 @@ namespace tui {
             exit(1);
         }
 #else // not windows
-        if (system("stty raw") != 0) {
-            err(1, "couldn't set stty raw");
-        }
-        if (system("stty -echo") != 0) {
-            err(1, "couldn't set stty -echo");
-        }
-        // struct termios term{};
-        // if (tcgetattr(STDIN_FILENO, &term) == -1) {
-        //     err(1, "error getting terminal attributes");
-        // }
-        // struct termios raw = term;
-        // raw.c_lflag &= ~(ICANON | ECHO);
-        // if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == -1) {
-        //     err(1, "error setting terminal to raw mode");
-        // }
+        auto& state = term_state();
+        if (!state.saved) {
+            if (tcgetattr(STDIN_FILENO, &state.orig) == -1) {
+                err(1, "error getting terminal attributes");
+            }
+            state.saved = true;
+        }
+        // same as `stty raw -echo`: no line editing, no signals, no output processing
+        state.raw = state.orig;
+        state.raw.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+        state.raw.c_oflag &= ~OPOST;
+        state.raw.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+        state.raw.c_cflag &= ~(CSIZE | PARENB);
+        state.raw.c_cflag |= CS8;
+        state.raw.c_cc[VMIN] = 1;
+        state.raw.c_cc[VTIME] = 0;
+        if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &state.raw) == -1) {
+            err(1, "error setting terminal to raw mode");
+        }
+        state.raw_enabled = true;
 #endif
     }
 
@@ -105,21 +246,15 @@ namespace tui {
             exit(1);
         }
 #else // not windows
-        if (system("stty cooked") != 0) {
-            err(1, "couldn't set stty cooked");
-        }
-        if (system("stty echo") != 0) {
-            err(1, "couldn't set stty echo");
-        }
-        // struct termios term{};
-        // if (tcgetattr(STDIN_FILENO, &term) == -1) {
-        //     err(1, "error getting terminal attributes");
-        // }
-        // // Restore original attributes
-        // term.c_lflag |= (ICANON | ECHO);
-        // if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &term) == -1) {
-        //     err(1, "error restoring terminal mode");
-        // }
+        auto& state = term_state();
+        if (!state.saved) {
+            return;
+        }
+        // restore the exact original attributes
+        if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &state.orig) == -1) {
+            err(1, "error restoring terminal mode");
+        }
+        state.raw_enabled = false;
 #endif
     }
 
@@ -149,8 +284,7 @@ namespace tui {
     namespace cursor {
 // template for moving cursor
 // moves cursor `n` times to `dir`
-#define move_n(dir, ch)                                                                                                \
-    inline void dir(unsigned n = 1) { csi(n, '#', ch); }
+#define move_n(dir, ch) csi_n_fn(dir, 1, ch)
 
         move_n(up, 'A');
         move_n(down, 'B');
@@ -158,27 +292,30 @@ namespace tui {
         move_n(left, 'D');
 
         // moves cursor one row up, scrolling if needed
-        esc_fn(up_n_scroll, 'M');
+        esc_fn(up_n_scroll, "M");
         // moves cursor to beginning of next line, `n` rows down
         move_n(next_line, 'E');
         // moves cursor to beginning of previous line, `n` rows up
         move_n(prev_line, 'F');
 
         // moves cursor to home position (1;1)
-        csi_fn(home, 'H');
+        csi_fn(home, "H");
         // moves cursor to (`row`; `col`), INFO: both `row` and `col` start at 1
-        inline void set_position(unsigned row, unsigned col) { csi(row, ';', col, 'H'); }
+        inline void set_position(unsigned row, unsigned col) {
+            char buf[encode::MAX_SEQ];
+            put(buf, encode::cursor_position(buf, row, col));
+        }
         // moves cursor to column `n`
         move_n(to_column, 'G');
 #undef move_n
 
         // save cursor position
-        esc_fn(save, '7');
+        esc_fn(save, "7");
         // restore previously saved cursor position
-        esc_fn(restore, '8');
+        esc_fn(restore, "8");
 
         // set visibility
-        inline void visible(bool visible) { csi("?25", (visible ? 'h' : 'l')); }
+        inline void visible(bool visible) { std::cout << (visible ? "\x1B[?25h" : "\x1B[?25l"); }
 
         // tell the terminal to check where the cursor is
         csi_fn(query_position, "6n");
@@ -221,19 +358,81 @@ namespace tui {
         csi_fn(clear_line_right, "K");
 
         // erases
-        inline void erase_in_line(unsigned n = 0) { csi(n, 'K'); }
-        inline void erase_in_display(unsigned n = 0) { csi(n, 'J'); }
+        csi_n_fn(erase_in_line, 0, 'K');
+        csi_n_fn(erase_in_display, 0, 'J');
         csi_fn(erase_saved_lines, "3J");
 
         csi_fn(save, "?47h");
         csi_fn(restore, "?47l");
 
-        inline void alternative_buffer(bool enable) { csi("?1049", (enable ? 'h' : 'l')); }
+        inline void alternative_buffer(bool enable) { std::cout << (enable ? "\x1B[?1049h" : "\x1B[?1049l"); }
+
+        csi_n_fn(scroll_up, 1, 'S');
+        csi_n_fn(scroll_down, 1, 'T');
+        // only the rows in [`top`;`bottom`] (starting at 1) are scrolled, moves the cursor home
+        inline void scroll_region(unsigned top, unsigned bottom) {
+            char buf[encode::MAX_SEQ];
+            put(buf, encode::scroll_region(buf, top, bottom));
+        }
+        // scroll the whole screen again, moves the cursor home
+        csi_fn(reset_scroll_region, "r");
 
-        inline void scroll_up(unsigned n = 1) { csi(n, 'S'); }
-        inline void scroll_down(unsigned n = 1) { csi(n, 'T'); }
+        // the number of times the terminal was resized (SIGWINCH-es received)
+        // INFO: a lock-free atomic, so it can be incremented from the signal handler
+        inline std::atomic<unsigned>& resizes() {
+            static std::atomic<unsigned> count{0};
+            return count;
+        }
+
+#ifndef _WIN32
+        // a byte is written here on every SIGWINCH, so `poll()`-ing the other end wakes up on resize, -1 if unused
+        inline std::atomic<int>& resize_notify_fd() {
+            static std::atomic<int> fd{-1};
+            return fd;
+        }
+
+        // the terminal size, queried again only after a SIGWINCH arrived
+        struct SizeCache {
+            // the controlling terminal, kept open
+            int tty = -1;
+            // (rows << 16) | cols
+            std::atomic<std::uint32_t> size{0};
+            // `resizes()` when `size` was queried, a burst of SIGWINCH-es means a single query
+            std::atomic<unsigned> queried_at;
+
+            SizeCache() : queried_at(resizes().load() - 1) {
+                // open the controlling terminal.
+                this->tty = open("/dev/tty", O_RDWR | O_CLOEXEC);
+                if (this->tty < 0) {
+                    err(1, "/dev/tty");
+                }
+                struct sigaction sa{};
+                // only count and notify, everything else happens outside of the signal handler
+                sa.sa_handler = [](int /*sig*/) {
+                    auto saved_errno = errno;
+                    resizes().fetch_add(1, std::memory_order_relaxed);
+                    auto fd = resize_notify_fd().load();
+                    const char byte = 0;
+                    if (fd >= 0 && ::write(fd, &byte, 1) < 0) {
+                        // full, there's a notification waiting anyway
+                    }
+                    errno = saved_errno;
+                };
+                sa.sa_flags = SA_RESTART; // restart functions if interrupted by handler
+                sigaction(SIGWINCH, &sa, nullptr);
+            }
+            SizeCache(const SizeCache&) = delete;
+            SizeCache& operator=(const SizeCache&) = delete;
+            ~SizeCache() { close(this->tty); }
+        };
+        inline SizeCache& size_cache() {
+            static SizeCache cache;
+            return cache;
+        }
+#endif
 
         // get the size of the terminal.
+        // cached, it's only queried again after the terminal was resized
         // returns: (rows;cols)/(y;x)
         inline std::pair<unsigned, unsigned> size() {
 #ifdef _WIN32
@@ -243,27 +442,338 @@ namespace tui {
 
             return {rows, columns};
 #else
-            struct winsize ws{};
-            int fd = 0;
+            auto& cache = size_cache();
+            // read before querying, so a resize during the query means another one next time
+            auto count = resizes().load();
+            if (count != cache.queried_at.load()) {
+                // get window size of terminal
+                struct winsize ws{};
+                if (ioctl(cache.tty, TIOCGWINSZ, &ws) < 0) {
+                    err(1, "/dev/tty");
+                }
+                cache.size.store((static_cast<std::uint32_t>(ws.ws_row) << 16U) | ws.ws_col);
+                cache.queried_at.store(count);
+            }
+            auto size = cache.size.load();
+            return {size >> 16U, size & 0xFFFFU};
+#endif
+        }
+    } // namespace screen
+
+    // mouse reporting, decoded into `Mouse` inputs by "input.hpp"
+    // WARN: only decoded on unix
+    namespace mouse {
+        enum class Tracking : unsigned {
+            Off = 0,
+            // presses, releases and the wheel
+            Clicks = 1000,
+            // + motion while a button is held down
+            Drag = 1002,
+            // + every motion, even with no buttons held down
+            Motion = 1003,
+        };
 
-            // open the controlling terminal.
-            fd = open("/dev/tty", O_RDWR | O_CLOEXEC);
-            if (fd < 0) {
-                err(1, "/dev/tty");
+        // the enabled `Tracking` mode
+        // INFO: a lock-free atomic, so `suspend()` can read it from a signal handler
+        inline std::atomic<unsigned>& tracking() {
+            static std::atomic<unsigned> mode{0};
+            return mode;
+        }
+
+        // `CSI ?<mode>h` with the SGR encoding (`CSI ?1006h`), `l`-s if not `enable`
+        inline char* encode(char* out, unsigned mode, bool enable) {
+            const char set = enable ? 'h' : 'l';
+            out = tui::encode::literal(out, "\x1B[?");
+            out = tui::encode::uint(out, mode);
+            *out++ = set;
+            out = tui::encode::literal(out, "\x1B[?1006");
+            *out++ = set;
+            return out;
+        }
+
+        inline void disable() {
+            auto mode = tracking().exchange(0);
+            if (mode != 0) {
+                char seq[tui::encode::MAX_SEQ];
+                put(seq, encode(seq, mode, false));
             }
+        }
+        inline void enable(Tracking mode = Tracking::Drag) {
+            disable();
+            if (mode == Tracking::Off) {
+                return;
+            }
+            char seq[tui::encode::MAX_SEQ];
+            put(seq, encode(seq, static_cast<unsigned>(mode), true));
+            tracking() = static_cast<unsigned>(mode);
+        }
+    } // namespace mouse
 
-            // get window size of terminal
-            if (ioctl(fd, TIOCGWINSZ, &ws) < 0) {
-                err(1, "/dev/tty");
+    // is bracketed paste on
+    // INFO: a lock-free atomic, so `suspend()` can read it from a signal handler
+    inline std::atomic<bool>& bracketed_paste_enabled() {
+        static std::atomic<bool> enabled{false};
+        return enabled;
+    }
+    // pasted text arrives as a single `Input` (see `Input::paste` in "input.hpp") instead of key by key
+    // WARN: only decoded on unix
+    inline void bracketed_paste(bool enable) {
+        std::cout << (enable ? "\x1B[?2004h" : "\x1B[?2004l");
+        bracketed_paste_enabled() = enable;
+    }
+
+#ifndef _WIN32
+    // write `request` followed by a device attributes query, which every terminal answers, and read what comes back
+    // until that answer, so terminals ignoring the `request` don't make us wait until `timeout_ms`
+    // NOTE: needs raw mode, call it after `init()` and before reading any input, keys pressed meanwhile are lost
+    // returns: the number of bytes read into `buf`
+    inline size_t query_terminal(const char* request, char* buf, size_t size, int timeout_ms) {
+        std::cout << request << "\x1B[c";
+        std::cout.flush();
+
+        size_t len = 0;
+        bool answered = false;
+        using clock = std::chrono::steady_clock;
+        auto deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (!answered && len < size) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+            pollfd pfd{STDIN_FILENO, POLLIN, 0};
+            if (left.count() <= 0 || poll(&pfd, 1, static_cast<int>(left.count())) <= 0) {
+                break;
+            }
+            auto got = ::read(STDIN_FILENO, buf + len, size - len);
+            if (got <= 0) {
+                break;
+            }
+            len += static_cast<size_t>(got);
+            // the device attributes, `CSI ? 6 2 ; ... c`, come last
+            for (size_t i = 0; i + 2 < len && !answered; ++i) {
+                if (buf[i] != ESC || buf[i + 1] != '[' || buf[i + 2] != '?') {
+                    continue;
+                }
+                auto end = i + 3;
+                while (end < len && ((buf[end] >= '0' && buf[end] <= '9') || buf[end] == ';')) {
+                    ++end;
+                }
+                answered = end < len && buf[end] == 'c';
             }
+        }
+        return len;
+    }
+#endif
+
+    // asks the terminal whether it knows synchronized output (mode 2026, see `Output::synchronized()`) with DECRQM
+    // NOTE: needs raw mode, call it after `init()` and before reading any input, keys pressed meanwhile are lost
+    // WARN: always false on windows
+    inline bool supports_synchronized_output(int timeout_ms = 100) {
+#ifdef _WIN32
+        (void)timeout_ms;
+        return false;
+#else
+        char buf[256];
+        auto len = query_terminal("\x1B[?2026$p", buf, sizeof(buf), timeout_ms);
 
-            // printf("%d rows by %d columns\n", ws.ws_row, ws.ws_col);
-            // printf("(%d by %d pixels)\n", ws.ws_xpixel, ws.ws_ypixel);
-            close(fd);
-            return {ws.ws_row, ws.ws_col};
+        // the mode report: `CSI ? 2 0 2 6 ; Ps $ y`, where `Ps` is 1 (set) or 2 (reset) if it's known,
+        // 3 if it's always on, 0 or 4 if it's not
+        static const char REPORT[] = "\x1B[?2026;";
+        const auto n = sizeof(REPORT) - 1;
+        for (size_t i = 0; i + n + 2 < len; ++i) {
+            if (std::memcmp(buf + i, REPORT, n) == 0 && buf[i + n + 1] == '$' && buf[i + n + 2] == 'y') {
+                auto ps = buf[i + n];
+                return ps == '1' || ps == '2' || ps == '3';
+            }
+        }
+        return false;
 #endif
+    }
+
+    // asks the terminal whether it knows REP (`CSI n b`, repeat the last character), which no query reports:
+    // writes a space and repeats it twice at (1;1), then checks where the cursor ended up
+    // NOTE: needs raw mode, call it after `init()` and before drawing or reading any input, as it overwrites the first
+    // 3 cells and keys pressed meanwhile are lost
+    // WARN: always false on windows
+    inline bool supports_repeat(int timeout_ms = 100) {
+#ifdef _WIN32
+        (void)timeout_ms;
+        return false;
+#else
+        char buf[256];
+        // saved and restored around it, with the style
+        auto len = query_terminal("\x1B" "7\x1B[H \x1B[2b\x1B[6n\x1B" "8", buf, sizeof(buf), timeout_ms);
+
+        // the cursor position report: `CSI 1 ; 4 R` if the space was repeated, `CSI 1 ; 2 R` if not
+        static const char REPORT[] = "\x1B[1;";
+        const auto n = sizeof(REPORT) - 1;
+        for (size_t i = 0; i + n + 1 < len; ++i) {
+            if (std::memcmp(buf + i, REPORT, n) == 0 && buf[i + n + 1] == 'R') {
+                return buf[i + n] == '4';
+            }
         }
-    } // namespace screen
+        return false;
+#endif
+    }
+
+    // how many colors the terminal shows, colors it doesn't have are written as the closest one it does
+    enum class ColorDepth : std::uint8_t {
+        // the 16 basic ones: 8 and their bright variants
+        Basic = 0,
+        // the 256 indexed ones
+        Indexed = 1,
+        // any rgb color (truecolor)
+        Rgb = 2,
+    };
+
+    // guess the color depth from the environment: `COLORTERM` (truecolor or 24bit), then `TERM` (*-direct, *-256color)
+    // without spawning anything or asking the terminal
+    // WARN: `COLORTERM` usually doesn't get through ssh, see `supports_rgb()` for asking the terminal
+    inline ColorDepth detect_color_depth() {
+        const char* colorterm = std::getenv("COLORTERM");
+        if (colorterm != nullptr &&
+            (std::strcmp(colorterm, "truecolor") == 0 || std::strcmp(colorterm, "24bit") == 0)) {
+            return ColorDepth::Rgb;
+        }
+#ifdef _WIN32
+        // the console knows rgb colors ever since it knows escape sequences
+        return ColorDepth::Rgb;
+#else
+        const char* term = std::getenv("TERM");
+        if (term == nullptr) {
+            return ColorDepth::Basic;
+        }
+        if (std::strstr(term, "-direct") != nullptr || std::strstr(term, "truecolor") != nullptr) {
+            return ColorDepth::Rgb;
+        }
+        return (std::strstr(term, "256col") != nullptr) ? ColorDepth::Indexed : ColorDepth::Basic;
+#endif
+    }
+
+    // the color depth every color is written with, `detect_color_depth()` at first
+    // eg.: `tui::color_depth() = tui::ColorDepth::Rgb;` to write every color as it is
+    inline std::atomic<ColorDepth>& color_depth() {
+        static std::atomic<ColorDepth> depth{detect_color_depth()};
+        return depth;
+    }
+
+    // asks the terminal whether it shows rgb colors: sets one and asks for the current SGR back (DECRQSS),
+    // terminals without them report the closest indexed color or nothing
+    // NOTE: needs raw mode, call it after `init()` and before reading any input, keys pressed meanwhile are lost
+    // WARN: always false on windows
+    inline bool supports_rgb(int timeout_ms = 100) {
+#ifdef _WIN32
+        (void)timeout_ms;
+        return false;
+#else
+        char buf[256];
+        auto len = query_terminal("\x1B[38;2;1;2;3m\x1BP$qm\x1B\\\x1B[0m", buf, sizeof(buf), timeout_ms);
+
+        // the report: `DCS 1 $ r ... 38;2;1;2;3 m ST`, with ':' instead of ';' in the color on some
+        static const char VALID[] = "\x1BP1$r";
+        const char* report = std::search(buf, buf + len, VALID, VALID + sizeof(VALID) - 1);
+        for (const char* at = report; at + 5 <= buf + len; ++at) {
+            if (at[0] == '1' && at[2] == '2' && at[4] == '3' && (at[1] == ';' || at[1] == ':') && at[3] == at[1]) {
+                return true;
+            }
+        }
+        return false;
+#endif
+    }
+
+    // the xterm palette, and the closest of its colors to an rgb one from lookup tables
+    namespace palette {
+        // the basic colors as xterm shows them by default, terminals (and themes) differ
+        constexpr std::uint8_t BASIC[16][3] = {
+            {0, 0, 0},       {205, 0, 0},   {0, 205, 0},   {205, 205, 0},
+            {0, 0, 238},     {205, 0, 205}, {0, 205, 205}, {229, 229, 229},
+            {127, 127, 127}, {255, 0, 0},   {0, 255, 0},   {255, 255, 0},
+            {92, 92, 255},   {255, 0, 255}, {0, 255, 255}, {255, 255, 255},
+        };
+        // the levels of each channel in the 6x6x6 color cube, [16;231]
+        constexpr std::uint8_t CUBE[6] = {0, 95, 135, 175, 215, 255};
+
+        // the rgb value of the indexed color `ix`: the basic ones, the cube, then 24 grays in [232;255]
+        inline void rgb(std::uint8_t ix, std::uint8_t (&out)[3]) {
+            if (ix < 16) {
+                std::memcpy(out, BASIC[ix], 3);
+            } else if (ix < 232) {
+                out[0] = CUBE[(ix - 16) / 36];
+                out[1] = CUBE[(ix - 16) / 6 % 6];
+                out[2] = CUBE[(ix - 16) % 6];
+            } else {
+                out[0] = out[1] = out[2] = static_cast<std::uint8_t>(8 + ((ix - 232) * 10));
+            }
+        }
+
+        // squared, the eye is more sensitive to green and less to blue
+        inline unsigned distance(unsigned r, unsigned g, unsigned b, const std::uint8_t (&to)[3]) {
+            auto dr = static_cast<int>(r) - to[0];
+            auto dg = static_cast<int>(g) - to[1];
+            auto db = static_cast<int>(b) - to[2];
+            return static_cast<unsigned>((2 * dr * dr) + (4 * dg * dg) + (3 * db * db));
+        }
+
+        // the closest of the cube and the grays, the basic ones are left out as they differ between terminals
+        // the channels are weighted separately, so the closest in the cube is the closest level of each
+        inline std::uint8_t closest_indexed(unsigned r, unsigned g, unsigned b) {
+            auto level = [](unsigned v) -> unsigned { return (v < 48) ? 0 : (v < 115) ? 1 : (v - 35) / 40; };
+            auto cube = static_cast<std::uint8_t>(16 + (36 * level(r)) + (6 * level(g)) + level(b));
+            auto gray_level = ((2 * r) + (4 * g) + (3 * b)) / 9;
+            auto gray = static_cast<std::uint8_t>(232 + ((gray_level < 8) ? 0 : std::min((gray_level - 3) / 10, 23U)));
+            std::uint8_t cube_rgb[3];
+            std::uint8_t gray_rgb[3];
+            palette::rgb(cube, cube_rgb);
+            palette::rgb(gray, gray_rgb);
+            return (palette::distance(r, g, b, gray_rgb) < palette::distance(r, g, b, cube_rgb)) ? gray : cube;
+        }
+        inline std::uint8_t closest_basic(unsigned r, unsigned g, unsigned b) {
+            std::uint8_t best = 0;
+            auto best_distance = palette::distance(r, g, b, BASIC[0]);
+            for (std::uint8_t ix = 1; ix < 16; ++ix) {
+                auto distance = palette::distance(r, g, b, BASIC[ix]);
+                if (distance < best_distance) {
+                    best = ix;
+                    best_distance = distance;
+                }
+            }
+            return best;
+        }
+
+        // the top 5 bits of each channel
+        constexpr unsigned LUT_SIZE = 1U << 15U;
+        constexpr unsigned lut_key(std::uint8_t r, std::uint8_t g, std::uint8_t b) {
+            return ((r >> 3U) << 10U) | ((g >> 3U) << 5U) | (b >> 3U);
+        }
+        // `closest(r, g, b)` for every `lut_key()`, each channel in the middle of what its 5 bits cover
+        inline std::vector<std::uint8_t> lut(std::uint8_t (*closest)(unsigned, unsigned, unsigned)) {
+            std::vector<std::uint8_t> table(LUT_SIZE);
+            for (unsigned key = 0; key < LUT_SIZE; ++key) {
+                auto r = ((key >> 10U) << 3U) | 4U;
+                auto g = (((key >> 5U) & 31U) << 3U) | 4U;
+                auto b = ((key & 31U) << 3U) | 4U;
+                table[key] = closest(r, g, b);
+            }
+            return table;
+        }
+
+        // the closest indexed color to (`r`;`g`;`b`), a lookup after the first call builds the table (32K)
+        inline std::uint8_t indexed(std::uint8_t r, std::uint8_t g, std::uint8_t b) {
+            static const std::vector<std::uint8_t> LUT = palette::lut(palette::closest_indexed);
+            return LUT[palette::lut_key(r, g, b)];
+        }
+        // the closest basic color to (`r`;`g`;`b`), a lookup after the first call builds the table (32K)
+        inline std::uint8_t basic(std::uint8_t r, std::uint8_t g, std::uint8_t b) {
+            static const std::vector<std::uint8_t> LUT = palette::lut(palette::closest_basic);
+            return LUT[palette::lut_key(r, g, b)];
+        }
+        // the closest basic color to the indexed one `ix`
+        inline std::uint8_t basic(std::uint8_t ix) {
+            if (ix < 16) {
+                return ix;
+            }
+            std::uint8_t value[3];
+            palette::rgb(ix, value);
+            return palette::basic(value[0], value[1], value[2]);
+        }
+    } // namespace palette
 
     namespace text {
         namespace style {
@@ -279,23 +789,24 @@ namespace tui {
                 strikethrough = 9,
             };
 
-            inline std::string style(const Style& style) { return concat(CSI, static_cast<unsigned>(style), 'm'); }
+            inline std::string style(const Style& style) {
+                char buf[encode::MAX_SEQ];
+                return {buf, encode::sgr(buf, static_cast<unsigned>(style))};
+            }
 
 // generate for cout << STYLE_style(); eg.: cout << bold_style();
 #define stylize(STYLE)                                                                                                 \
     inline std::string STYLE##_style() { return style(Style::STYLE); }
 // generate for cout << STYLE_style(text); eg.: cout << bold_style(text);
 #define stylize_text(STYLE)                                                                                            \
-    inline std::string STYLE##_style(const std::string& text) {                                                        \
-        return concat(style(Style::STYLE), text, reset_style());                                                       \
-    }                                                                                                                  \
-    inline std::string STYLE##_style(const char* text) { return concat(style(Style::STYLE), text, reset_style()); }
+    inline std::string STYLE##_style(const std::string& text) { return style(Style::STYLE) + text + reset_style(); }   \
+    inline std::string STYLE##_style(const char* text) { return style(Style::STYLE) + text + reset_style(); }
 // generate all
 #define make_stylizer(STYLE) stylize(STYLE) stylize_text(STYLE)
 
             stylize(reset);
             inline std::string style_and_reset(const Style& st, const std::string& text) {
-                return concat(style(st), text, reset_style());
+                return style(st) + text + reset_style();
             }
 
             make_stylizer(bold);
@@ -313,10 +824,10 @@ namespace tui {
             // printf '\e]8;;http://example.com\e\\This is a link\e]8;;\e\\\n'
             // printf 'ESC]8;;{link}ESC\\{text}ESC]8;;ESC\\'
             inline std::string link(const std::string& link, const std::string& text) {
-                return concat(ESC, "]8;;", link, ESC, "\\", text, ESC, "]8;;", ESC, "\\");
+                return "\x1B]8;;" + link + "\x1B\\" + text + "\x1B]8;;\x1B\\";
             }
             inline std::string link(const char* link, const char* text) {
-                return concat(ESC, "]8;;", link, ESC, "\\", text, ESC, "]8;;", ESC, "\\");
+                return style::link(std::string(link), std::string(text));
             }
 
         } // namespace style
@@ -336,7 +847,8 @@ namespace tui {
 
             // fg or bg
             inline std::string colorizer(const Color& c, bool fg) {
-                return concat(CSI, (fg ? '3' : '4'), static_cast<unsigned>(c), 'm');
+                char buf[encode::MAX_SEQ];
+                return {buf, encode::sgr(buf, (fg ? 30U : 40U) + static_cast<unsigned>(c))};
             }
 
 // generate for cout << COLOR_{fg, bg}();
@@ -347,16 +859,16 @@ namespace tui {
 // generate for cout << COLOR_{fg, bg}(text);
 #define colorize_text(COLOR)                                                                                           \
     inline std::string COLOR##_fg(const std::string& text) {                                                           \
-        return concat(colorizer(Color::COLOR, true), text, style::reset_style());                                      \
+        return colorizer(Color::COLOR, true) + text + style::reset_style();                                            \
     }                                                                                                                  \
     inline std::string COLOR##_fg(const char* text) {                                                                  \
-        return concat(colorizer(Color::COLOR, true), text, style::reset_style());                                      \
+        return colorizer(Color::COLOR, true) + text + style::reset_style();                                            \
     }                                                                                                                  \
     inline std::string COLOR##_bg(const std::string& text) {                                                           \
-        return concat(colorizer(Color::COLOR, false), text, style::reset_style());                                     \
+        return colorizer(Color::COLOR, false) + text + style::reset_style();                                           \
     }                                                                                                                  \
     inline std::string COLOR##_bg(const char* text) {                                                                  \
-        return concat(colorizer(Color::COLOR, false), text, style::reset_style());                                     \
+        return colorizer(Color::COLOR, false) + text + style::reset_style();                                           \
     }
 
 // generate all
@@ -375,28 +887,426 @@ namespace tui {
 #undef colorize
 
             // r, g, b values have to be valid:  [0;255]
+            // the closest indexed or basic color if the terminal doesn't show rgb ones, see `tui::color_depth()`
             inline std::string rgb(unsigned r, unsigned g, unsigned b, bool fg) {
                 assert(r <= 255 && g <= 255 && b <= 255);
-                return concat(CSI, (fg ? '3' : '4'), "8;2;", r, ';', g, ';', b, 'm');
+                auto r8 = static_cast<std::uint8_t>(r);
+                auto g8 = static_cast<std::uint8_t>(g);
+                auto b8 = static_cast<std::uint8_t>(b);
+                char buf[encode::MAX_SEQ];
+                switch (color_depth().load(std::memory_order_relaxed)) {
+                case ColorDepth::Rgb:
+                    return {buf, encode::rgb(buf, r, g, b, fg)};
+                case ColorDepth::Indexed:
+                    return {buf, encode::indexed(buf, palette::indexed(r8, g8, b8), fg)};
+                case ColorDepth::Basic:
+                    break;
+                }
+                auto ix = palette::basic(r8, g8, b8);
+                return {buf, encode::sgr(buf, (ix < 8 ? (fg ? 30U : 40U) : (fg ? 82U : 92U)) + ix)};
             }
             inline std::string rgb(unsigned r, unsigned g, unsigned b, bool fg, const std::string& text) {
-                return concat(rgb(r, g, b, fg), text, style::reset_style());
+                return rgb(r, g, b, fg) + text + style::reset_style();
             }
 
         } // namespace color
 
     } // namespace text
 
+    // a terminal color: unset, the terminal's default, one of the 16 basic ones, one of the 256 indexed ones or rgb
+    struct Color {
+        enum class Kind : std::uint8_t {
+            // leave the color as it is
+            None = 0,
+            // the terminal's default color
+            Default,
+            // `ix` in [0;15], where [8;15] are the bright variants of [0;7]
+            Basic,
+            // `ix` in [0;255]
+            Indexed,
+            Rgb,
+        };
+
+        Kind kind = Kind::None;
+        std::uint8_t ix = 0;
+        std::uint8_t r = 0;
+        std::uint8_t g = 0;
+        std::uint8_t b = 0;
+
+        constexpr Color() {}
+        constexpr Color(Kind kind, std::uint8_t ix, std::uint8_t r = 0, std::uint8_t g = 0, std::uint8_t b = 0)
+            : kind(kind), ix(ix), r(r), g(g), b(b) {}
+
+        // `text::color::Color::basic` means the terminal's default
+        static constexpr Color basic(text::color::Color c) {
+            return c == text::color::Color::basic ? Color(Kind::Default, 0)
+                                                  : Color(Kind::Basic, static_cast<std::uint8_t>(c));
+        }
+        static constexpr Color bright(text::color::Color c) {
+            return c == text::color::Color::basic ? Color(Kind::Default, 0)
+                                                  : Color(Kind::Basic, static_cast<std::uint8_t>(c) + 8);
+        }
+        static constexpr Color indexed(std::uint8_t ix) { return Color(Kind::Indexed, ix); }
+        static constexpr Color rgb(std::uint8_t r, std::uint8_t g, std::uint8_t b) {
+            return Color(Kind::Rgb, 0, r, g, b);
+        }
+
+        constexpr bool is_set() const { return this->kind != Kind::None; }
+
+        // the closest color a terminal with `depth` shows, itself if it shows it
+        Color fit(ColorDepth depth) const {
+            if (this->kind == Kind::Rgb && depth != ColorDepth::Rgb) {
+                return (depth == ColorDepth::Indexed)
+                           ? Color::indexed(palette::indexed(this->r, this->g, this->b))
+                           : Color(Kind::Basic, palette::basic(this->r, this->g, this->b));
+            }
+            if (this->kind == Kind::Indexed && depth == ColorDepth::Basic) {
+                return Color(Kind::Basic, palette::basic(this->ix));
+            }
+            return *this;
+        }
+
+        constexpr bool operator==(const Color& other) const {
+            return (this->kind == other.kind && this->ix == other.ix && this->r == other.r && this->g == other.g &&
+                    this->b == other.b);
+        }
+        constexpr bool operator!=(const Color& other) const { return !(*this == other); }
+
+        // write the SGR parameters selecting this color, each followed by a ';', nothing if unset
+        // the closest one the terminal shows, see `tui::color_depth()`
+        char* encode(char* out, bool fg) const {
+            auto depth = color_depth().load(std::memory_order_relaxed);
+            if ((this->kind == Kind::Rgb && depth != ColorDepth::Rgb) ||
+                (this->kind == Kind::Indexed && depth == ColorDepth::Basic)) {
+                return this->fit(depth).encode(out, fg);
+            }
+            switch (this->kind) {
+            case Kind::None:
+                return out;
+            case Kind::Default:
+                out = tui::encode::uint(out, fg ? 39 : 49);
+                break;
+            case Kind::Basic:
+                out = tui::encode::uint(out, (this->ix < 8 ? (fg ? 30U : 40U) : (fg ? 82U : 92U)) + this->ix);
+                break;
+            case Kind::Indexed:
+                out = fg ? tui::encode::literal(out, "38;5;") : tui::encode::literal(out, "48;5;");
+                out = tui::encode::uint(out, this->ix);
+                break;
+            case Kind::Rgb:
+                out = fg ? tui::encode::literal(out, "38;2;") : tui::encode::literal(out, "48;2;");
+                out = tui::encode::uint(out, this->r);
+                *out++ = ';';
+                out = tui::encode::uint(out, this->g);
+                *out++ = ';';
+                out = tui::encode::uint(out, this->b);
+                break;
+            }
+            *out++ = ';';
+            return out;
+        }
+    };
+
+    // every `text::style::Style` attribute and the colors of a piece of text, packed into 12 bytes
+    // composes at compile time: `constexpr auto TITLE = tui::Style().bold().blue();`
+    // and is written as a single `CSI ...;...;... m`
+    class Style {
+        // bit `n` is set if the attribute `text::style::Style` with the value `n` is on
+        std::uint16_t attrs_ = 0;
+        Color fg_;
+        Color bg_;
+
+        static constexpr std::uint16_t bit(text::style::Style st) {
+            return static_cast<std::uint16_t>(1U << static_cast<unsigned>(st));
+        }
+
+      public:
+        constexpr Style() {}
+        constexpr Style(std::uint16_t attrs, const Color& fg, const Color& bg) : attrs_(attrs), fg_(fg), bg_(bg) {}
+
+        constexpr std::uint16_t attrs() const { return this->attrs_; }
+        constexpr const Color& fg() const { return this->fg_; }
+        constexpr const Color& bg() const { return this->bg_; }
+
+        constexpr bool has(text::style::Style st) const { return (this->attrs_ & Style::bit(st)) != 0; }
+        // the colors fit to `depth`, see `Color::fit()`
+        Style fit(ColorDepth depth) const { return Style(this->attrs_, this->fg_.fit(depth), this->bg_.fit(depth)); }
+        constexpr bool empty() const { return this->attrs_ == 0 && !this->fg_.is_set() && !this->bg_.is_set(); }
+
+        // turn attribute `st` on, `reset` turns everything off
+        constexpr Style with(text::style::Style st) const {
+            return st == text::style::Style::reset
+                       ? Style()
+                       : Style(static_cast<std::uint16_t>(this->attrs_ | Style::bit(st)), this->fg_, this->bg_);
+        }
+        constexpr Style without(text::style::Style st) const {
+            return Style(static_cast<std::uint16_t>(this->attrs_ & ~Style::bit(st)), this->fg_, this->bg_);
+        }
+        constexpr Style fg(const Color& fg) const { return Style(this->attrs_, fg, this->bg_); }
+        constexpr Style bg(const Color& bg) const { return Style(this->attrs_, this->fg_, bg); }
+
+        // the attributes of both, colors of `other` where it has them set
+        constexpr Style operator|(const Style& other) const {
+            return Style(static_cast<std::uint16_t>(this->attrs_ | other.attrs_),
+                         other.fg_.is_set() ? other.fg_ : this->fg_, other.bg_.is_set() ? other.bg_ : this->bg_);
+        }
+
+        constexpr bool operator==(const Style& other) const {
+            return (this->attrs_ == other.attrs_ && this->fg_ == other.fg_ && this->bg_ == other.bg_);
+        }
+        constexpr bool operator!=(const Style& other) const { return !(*this == other); }
+
+// generate this.STYLE(): eg this.italic()
+#define make_style(STYLE)                                                                                              \
+    constexpr Style STYLE() const { return this->with(text::style::Style::STYLE); }
+
+        make_style(bold);
+        make_style(dim);
+        make_style(italic);
+        make_style(underline);
+        make_style(blink);
+        make_style(inverted);
+        make_style(invisible);
+        make_style(strikethrough);
+#undef make_style
+
+// generate this.COLOR(): eg this.red()
+#define make_color(COLOR)                                                                                              \
+    constexpr Style COLOR() const { return this->fg(Color::basic(text::color::Color::COLOR)); }                        \
+    constexpr Style on_##COLOR() const { return this->bg(Color::basic(text::color::Color::COLOR)); }
+
+        make_color(black);
+        make_color(red);
+        make_color(green);
+        make_color(yellow);
+        make_color(blue);
+        make_color(magenta);
+        make_color(cyan);
+        make_color(white);
+        make_color(basic);
+#undef make_color
+
+        constexpr Style rgb(std::uint8_t r, std::uint8_t g, std::uint8_t b) const {
+            return this->fg(Color::rgb(r, g, b));
+        }
+        constexpr Style on_rgb(std::uint8_t r, std::uint8_t g, std::uint8_t b) const {
+            return this->bg(Color::rgb(r, g, b));
+        }
+
+        // write `CSI attrs;fg;bg m`, starting with a reset (`0;`) if `reset`
+        // nothing is written for an `empty()` style, unless `reset`
+        // NOTE: `out` has to have room for `encode::MAX_SEQ` bytes
+        char* encode(char* out, bool reset = false) const {
+            char* start = out;
+            out = tui::encode::literal(out, tui::encode::PREFIX_CSI);
+            if (reset) {
+                *out++ = '0';
+                *out++ = ';';
+            }
+            for (unsigned code = 1; code <= static_cast<unsigned>(text::style::Style::strikethrough); ++code) {
+                if ((this->attrs_ & (1U << code)) != 0) {
+                    *out++ = static_cast<char>('0' + code);
+                    *out++ = ';';
+                }
+            }
+            out = this->fg_.encode(out, true);
+            out = this->bg_.encode(out, false);
+            if (out == start + 2) {
+                return start;
+            }
+            // the last ';' becomes the final byte
+            out[-1] = 'm';
+            return out;
+        }
+        std::string sgr(bool reset = false) const {
+            char buf[tui::encode::MAX_SEQ];
+            return {buf, this->encode(buf, reset)};
+        }
+    };
+
+    // `std::string` that can be styled by chaining, eg.: `tui::string("hi").blue().bold()`
+    // whatever the chain, the result is a single SGR sequence, the text and one reset at the end
+    // an edit (`+=`, `append()`, `[]`, ...) drops the style, the edited content is the text then, so styling it
+    // again wraps all of it
+    // WARN: edits through a `std::string&` to it, or a reference or iterator kept from before, aren't noticed
     class string : public std::string {
+        // the text without styling, only used once `is_styled()`
+        mutable std::string plain_;
+        mutable Style style_;
+        mutable std::string link_;
+        // a reference or iterator to a character was handed out, the content might not be what was built
+        mutable bool touched_ = false;
+        // `display_width()`, until the next edit
+        mutable size_t width_ = 0;
+        mutable bool width_known_ = false;
+
+        string(const std::string& plain, const Style& style, const std::string& link)
+            : plain_(plain), style_(style), link_(link) {
+            char sgr[tui::encode::MAX_SEQ];
+            auto* sgr_end = style.encode(sgr);
+            this->reserve(plain.size() + (sgr_end - sgr) + (link.empty() ? 0 : link.size() + 14) + 4);
+            std::string::append(sgr, sgr_end);
+            if (!link.empty()) {
+                std::string::append("\x1B]8;;").append(link).append("\x1B\\");
+            }
+            std::string::append(plain);
+            if (!link.empty()) {
+                std::string::append("\x1B]8;;\x1B\\");
+            }
+            if (sgr_end != sgr) {
+                std::string::append("\x1B[0m");
+            }
+        }
+
+        bool is_styled() const { return !this->style_.empty() || !this->link_.empty(); }
+
+        // the content is about to change, it's just text from now on
+        void edit() const {
+            this->touched_ = false;
+            this->width_known_ = false;
+            if (this->is_styled()) {
+                this->plain_.clear();
+                this->style_ = Style();
+                this->link_.clear();
+            }
+        }
+        // a reference or iterator to a character is handed out
+        void touch() {
+            this->touched_ = true;
+            this->width_known_ = false;
+        }
+        // a character might've been changed in place since it was `touched_`, only then it's compared
+        void sync() const {
+            if (this->touched_ && this->is_styled() &&
+                static_cast<const std::string&>(*this) != string(this->plain_, this->style_, this->link_)) {
+                this->edit();
+            }
+            this->touched_ = false;
+        }
+        // what a mutator of `std::string` returns: itself as a `tui::string`, or an iterator
+        string& edited(std::string& /*self*/) { return *this; }
+        template <typename It> It edited(It it) { return it; }
+
       public:
         string() = default;
         template <typename T> string(T s) : std::string(concat(s)) {}
         string(const char* s) : std::string(s) {}
         string(const std::string& s) : std::string(s) {}
 
+        // the mutators of `std::string`, dropping the style first
+        template <typename T> string& operator+=(T&& value) {
+            this->edit();
+            std::string::operator+=(std::forward<T>(value));
+            return *this;
+        }
+        template <typename... Args>
+        auto append(Args&&... args) -> decltype(this->edited(std::string::append(std::forward<Args>(args)...))) {
+            this->edit();
+            return this->edited(std::string::append(std::forward<Args>(args)...));
+        }
+        template <typename... Args>
+        auto assign(Args&&... args) -> decltype(this->edited(std::string::assign(std::forward<Args>(args)...))) {
+            this->edit();
+            return this->edited(std::string::assign(std::forward<Args>(args)...));
+        }
+        template <typename... Args>
+        auto insert(Args&&... args) -> decltype(this->edited(std::string::insert(std::forward<Args>(args)...))) {
+            this->edit();
+            return this->edited(std::string::insert(std::forward<Args>(args)...));
+        }
+        template <typename... Args>
+        auto erase(Args&&... args) -> decltype(this->edited(std::string::erase(std::forward<Args>(args)...))) {
+            this->edit();
+            return this->edited(std::string::erase(std::forward<Args>(args)...));
+        }
+        template <typename... Args>
+        auto replace(Args&&... args) -> decltype(this->edited(std::string::replace(std::forward<Args>(args)...))) {
+            this->edit();
+            return this->edited(std::string::replace(std::forward<Args>(args)...));
+        }
+        void push_back(char ch) {
+            this->edit();
+            std::string::push_back(ch);
+        }
+        void pop_back() {
+            this->edit();
+            std::string::pop_back();
+        }
+        void clear() {
+            this->edit();
+            std::string::clear();
+        }
+        template <typename... Args> void resize(Args&&... args) {
+            this->edit();
+            std::string::resize(std::forward<Args>(args)...);
+        }
+
+        // a character that can be changed, might be an edit
+        using std::string::operator[];
+        using std::string::at;
+        using std::string::back;
+        using std::string::begin;
+        using std::string::end;
+        using std::string::front;
+        reference operator[](size_type pos) {
+            this->touch();
+            return std::string::operator[](pos);
+        }
+        reference at(size_type pos) {
+            this->touch();
+            return std::string::at(pos);
+        }
+        reference front() {
+            this->touch();
+            return std::string::front();
+        }
+        reference back() {
+            this->touch();
+            return std::string::back();
+        }
+        iterator begin() {
+            this->touch();
+            return std::string::begin();
+        }
+        iterator end() {
+            this->touch();
+            return std::string::end();
+        }
+
+        // the text without any styling
+        const std::string& plain() const {
+            this->sync();
+            if (this->is_styled()) {
+                return this->plain_;
+            }
+            return *this;
+        }
+        const Style& style() const {
+            this->sync();
+            return this->style_;
+        }
+        const std::string& link() const {
+            this->sync();
+            return this->link_;
+        }
+
+        // the number of columns it takes on the terminal, unlike `size()` it doesn't count escape sequences,
+        // wide (eg. CJK) characters count 2, combining ones none
+        // INFO: cached, it's only computed again after an edit
+        size_t display_width() const {
+            if (!this->width_known_) {
+                this->width_ = unicode::display_width(this->plain());
+                this->width_known_ = true;
+            }
+            return this->width_;
+        }
+
+        // add `style` to the current one
+        string styled(const Style& style) const { return {this->plain(), this->style_ | style, this->link_}; }
+
 // generate this.STYLE(): eg this.italic()
 #define make_style(STYLE)                                                                                              \
-    inline tui::string STYLE() const { return text::style::STYLE##_style(*this); }
+    inline tui::string STYLE() const { return this->styled(Style().STYLE()); }
 
         make_style(bold);
         make_style(dim);
@@ -410,8 +1320,8 @@ namespace tui {
 
 // generate this.COLOR(): eg this.red()
 #define make_color(COLOR)                                                                                              \
-    inline tui::string COLOR() const { return text::color::COLOR##_fg(*this); }                                        \
-    inline tui::string on_##COLOR() const { return text::color::COLOR##_bg(*this); }
+    inline tui::string COLOR() const { return this->styled(Style().COLOR()); }                                         \
+    inline tui::string on_##COLOR() const { return this->styled(Style().on_##COLOR()); }
 
         make_color(black);
         make_color(red);
@@ -424,25 +1334,782 @@ namespace tui {
         make_color(basic);
 #undef make_color
 
-        string link(const char* link) { return text::style::link(link, *this); }
-        string rgb(unsigned r, unsigned g, unsigned b) const { return text::color::rgb(r, g, b, true, *this); }
-        string on_rgb(unsigned r, unsigned g, unsigned b) const { return text::color::rgb(r, g, b, false, *this); }
+        string link(const char* link) const { return {this->plain(), this->style_, link}; }
+        string rgb(unsigned r, unsigned g, unsigned b) const {
+            assert(r <= 255 && g <= 255 && b <= 255);
+            return this->styled(Style().rgb(static_cast<std::uint8_t>(r), static_cast<std::uint8_t>(g),
+                                            static_cast<std::uint8_t>(b)));
+        }
+        string on_rgb(unsigned r, unsigned g, unsigned b) const {
+            assert(r <= 255 && g <= 255 && b <= 255);
+            return this->styled(Style().on_rgb(static_cast<std::uint8_t>(r), static_cast<std::uint8_t>(g),
+                                               static_cast<std::uint8_t>(b)));
+        }
+    };
+
+    // what the terminal is currently drawing with: attributes, colors and hyperlink
+    // so switching to the next `Style` only needs the difference, and nothing at all if it's the same
+    class SgrState {
+        Style style_;
+        std::string link_;
+        // false until the first full sequence is written, or after something unknown was written to the terminal
+        bool known_ = false;
+        // no link is open at first
+        bool link_known_ = true;
+
+        // SGR code turning off the attribute with the value of the index, 22 turns off both bold and dim
+        static constexpr unsigned off_code(unsigned attr) {
+            return attr == 1 || attr == 2 ? 22 : (attr == 0 || attr == 6 ? 0 : 20 + attr);
+        }
+
+        // `Kind::None` and `Kind::Default` both mean the default color, as styles are absolute here
+        static bool same_color(const Color& lhs, const Color& rhs) {
+            return (lhs.kind == Color::Kind::None || lhs.kind == Color::Kind::Default)
+                       ? (rhs.kind == Color::Kind::None || rhs.kind == Color::Kind::Default)
+                       : lhs == rhs;
+        }
+        static char* color_delta(char* out, const Color& from, const Color& to, bool fg) {
+            if (SgrState::same_color(from, to)) {
+                return out;
+            }
+            return to.is_set() ? to.encode(out, fg) : Color(Color::Kind::Default, 0).encode(out, fg);
+        }
+
+      public:
+        // forget everything, eg. after something else wrote to the terminal
+        void invalidate() {
+            this->known_ = false;
+            this->link_known_ = false;
+        }
+        void invalidate_style() { this->known_ = false; }
+        bool known() const { return this->known_; }
+        const Style& style() const { return this->style_; }
+        const std::string& link() const { return this->link_; }
+
+        // write the shortest sequence switching the terminal from the current style to `next`
+        // `next` is absolute: whatever it doesn't set is turned off
+        // NOTE: `out` has to have room for `encode::MAX_SEQ` bytes
+        char* style(char* out, const Style& next) {
+            if (!this->known_) {
+                this->style_ = next;
+                this->known_ = true;
+                return next.encode(out, true);
+            }
+            if (next == this->style_) {
+                return out;
+            }
+
+            // turn off what's on but not needed, turn on what's needed but not on, then colors
+            char* start = out;
+            out = encode::literal(out, encode::PREFIX_CSI);
+            unsigned removed = this->style_.attrs() & ~next.attrs();
+            unsigned added = next.attrs() & ~this->style_.attrs();
+            bool off_22 = false;
+            for (unsigned attr = 1; attr <= static_cast<unsigned>(text::style::Style::strikethrough); ++attr) {
+                if ((removed & (1U << attr)) == 0 || (SgrState::off_code(attr) == 22 && off_22)) {
+                    continue;
+                }
+                if (SgrState::off_code(attr) == 22) {
+                    // turns off both, turn back on the one still needed
+                    off_22 = true;
+                    added |= next.attrs() & ((1U << 1U) | (1U << 2U));
+                }
+                out = encode::uint(out, SgrState::off_code(attr));
+                *out++ = ';';
+            }
+            for (unsigned attr = 1; attr <= static_cast<unsigned>(text::style::Style::strikethrough); ++attr) {
+                if ((added & (1U << attr)) != 0) {
+                    *out++ = static_cast<char>('0' + attr);
+                    *out++ = ';';
+                }
+            }
+            out = SgrState::color_delta(out, this->style_.fg(), next.fg(), true);
+            out = SgrState::color_delta(out, this->style_.bg(), next.bg(), false);
+            this->style_ = next;
+            if (out == start + 2) {
+                return start;
+            }
+            out[-1] = 'm';
+
+            // resetting everything might still be shorter
+            char full[encode::MAX_SEQ];
+            auto* full_end = next.encode(full, true);
+            if (full_end - full < out - start) {
+                std::memcpy(start, full, static_cast<size_t>(full_end - full));
+                return start + (full_end - full);
+            }
+            return out;
+        }
+
+        // the sequence switching the terminal's hyperlink to `target`, empty if it's already that
+        // an empty `target` closes the current link
+        std::string link(const std::string& target) {
+            if (this->link_known_ && target == this->link_) {
+                return "";
+            }
+            this->link_ = target;
+            this->link_known_ = true;
+            return "\x1B]8;;" + target + "\x1B\\";
+        }
+    };
+
+    // how `Output` writes runs of the same character, see `Output::runs()`
+    enum class RunEncoding : std::uint8_t {
+        // as they are
+        Literal = 0,
+        // blanks with erase character (ECH, `CSI n X`) and a move past them, the rest as they are
+        Erase = 1,
+        // the character once, then repeated (REP, `CSI n b`), see `supports_repeat()`
+        Repeat = 2,
+    };
+
+    // growable byte arena in front of the terminal, flushed with a single `write(2)` (in the common case)
+    // once `attach()`-ed to `std::cout` it collects everything: the escape sequences of `tui::cursor`, `tui::screen`,
+    // ... and your own `std::cout << ...`-s, so a whole frame goes out at once on `std::cout.flush()`
+    class Output : public std::streambuf {
+      public:
+        struct Stats {
+            // written by the last flush
+            size_t bytes = 0;
+            // `write(2)` calls made by the last flush, more than 1 only on partial writes
+            size_t syscalls = 0;
+
+            // summed up over every flush
+            size_t total_bytes = 0;
+            size_t total_syscalls = 0;
+            size_t flushes = 0;
+
+            // `move_to()` calls and the bytes they saved compared to always moving absolutely
+            size_t cursor_moves = 0;
+            size_t cursor_bytes_saved = 0;
+
+            // runs of the same character written shorter, and the bytes that saved, see `runs()`
+            size_t runs = 0;
+            size_t runs_bytes_saved = 0;
+        };
+
+      private:
+        // the begin synchronized update sequence, `CSI ?2026h`, is put in front of the frame
+        static const size_t HEADROOM = 8;
+
+        // `HEADROOM` bytes, then the collected ones
+        std::vector<char> buf_;
+        // wrap each flush in a synchronized update
+        bool synchronized_ = false;
+        RunEncoding runs_ = RunEncoding::Literal;
+        // the last `observe()` stopped in the middle of a sequence, the rest of it would look like text
+        bool cut_ = false;
+        // the last `observe()` stopped in the body of a string sequence (OSC, DCS, ...), it goes on up to BEL or ST
+        bool in_string_ = false;
+
+        // what shows on a blank cell written with the terminal's current state, but not on an erased one
+        static constexpr unsigned BLANK_UNDERLINE = 1U << 0U;
+        static constexpr unsigned BLANK_INVERTED = 1U << 1U;
+        static constexpr unsigned BLANK_STRIKETHROUGH = 1U << 2U;
+        static constexpr unsigned BLANK_OVERLINE = 1U << 3U;
+        static constexpr unsigned BLANK_LINK = 1U << 4U;
+        static constexpr unsigned BLANK_ATTRS = BLANK_UNDERLINE | BLANK_INVERTED | BLANK_STRIKETHROUGH | BLANK_OVERLINE;
+        // the `BLANK_*` flags that might be on, followed through the SGRs written (unlike `sgr_`), as `Frame`
+        // writes its own, everything until the first reset
+        unsigned blank_ = BLANK_ATTRS;
+        // the buffer of the stream we're attached to, `nullptr` if detached
+        std::streambuf* prev_ = nullptr;
+        std::ostream* stream_ = nullptr;
+        Stats stats_;
+        SgrState sgr_;
+        // bytes at the start of the arena, that have already been `observe()`-d
+        size_t observed_ = 0;
+
+        // the logical cursor position (1-based), valid only if `cursor_known_`
+        unsigned row_ = 0;
+        unsigned col_ = 0;
+        bool cursor_known_ = false;
+        // columns of the screen, 0 if unknown
+        unsigned cols_ = 0;
+        // `screen::resizes()` the last time we looked
+        unsigned resizes_ = screen::resizes().load();
+
+        // the numeric parameter at `at` (`def` if missing), `at` is left on the first non-digit
+        static unsigned parse_param(const char*& at, const char* end, unsigned def) {
+            if (at == end || *at < '0' || *at > '9') {
+                return def;
+            }
+            unsigned n = 0;
+            for (; at != end && *at >= '0' && *at <= '9'; ++at) {
+                n = (n * 10) + static_cast<unsigned>(*at - '0');
+            }
+            return n;
+        }
+
+        // `blank` (`BLANK_*` flags) after the SGR with the parameters from `at` to `end`
+        static unsigned blank_after(unsigned blank, const char* at, const char* end) {
+            if (at != end && (*at < '0' || *at > '9') && *at != ';' && *at != ':') {
+                // private, eg. `CSI > 4 ; 2 m` sets the modifier keys
+                return blank;
+            }
+            // the parameters left of an extended color, -1 while its kind is next (`5;n` or `2;r;g;b`)
+            int color = 0;
+            while (true) {
+                auto n = Output::parse_param(at, end, 0);
+                // colon separated sub-parameters belong to this one, eg. `4:3` (curly underline) or `38:2::r:g:b`
+                const char* sub = at;
+                while (at != end && *at != ';') {
+                    if ((*at < '0' || *at > '9') && *at != ':') {
+                        return blank | BLANK_ATTRS;
+                    }
+                    ++at;
+                }
+                if (color < 0) {
+                    color = (n == 5) ? 1 : (n == 2) ? 3 : 0;
+                } else if (color > 0) {
+                    --color;
+                } else if (n == 0) {
+                    blank &= ~BLANK_ATTRS;
+                } else if (n == 4) {
+                    // `4:0` turns it off
+                    blank = (at - sub == 2 && sub[1] == '0') ? blank & ~BLANK_UNDERLINE : blank | BLANK_UNDERLINE;
+                } else if (n == 21 || n == 24) {
+                    blank = (n == 21) ? blank | BLANK_UNDERLINE : blank & ~BLANK_UNDERLINE;
+                } else if (n == 7 || n == 27) {
+                    blank = (n == 7) ? blank | BLANK_INVERTED : blank & ~BLANK_INVERTED;
+                } else if (n == 9 || n == 29) {
+                    blank = (n == 9) ? blank | BLANK_STRIKETHROUGH : blank & ~BLANK_STRIKETHROUGH;
+                } else if (n == 53 || n == 55) {
+                    blank = (n == 53) ? blank | BLANK_OVERLINE : blank & ~BLANK_OVERLINE;
+                } else if ((n == 38 || n == 48 || n == 58) && sub == at) {
+                    color = -1;
+                }
+                if (at == end) {
+                    return blank;
+                }
+                ++at;
+            }
+        }
+
+        // the end of a string sequence's body from `at`: its BEL or the ESC of its ST, `end` if it goes on
+        static const char* skip_string(const char* at, const char* end) {
+            while (at != end && *at != '\a' && *at != ESC) {
+                ++at;
+            }
+            return at;
+        }
+
+        // bytes that got into the arena past `style()`, `move_to()`, ... (eg. `std::cout << red_fg() << "hi"`)
+        // might have changed the terminal's state: follow the text and the sequences we understand, forget the rest
+        // `moving`: a cursor move is appended right after, not text
+        void observe(bool moving = false) {
+            // after a resize the terminal might've moved the cursor
+            auto resizes = screen::resizes().load(std::memory_order_relaxed);
+            if (resizes != this->resizes_) {
+                this->resizes_ = resizes;
+                this->cursor_known_ = false;
+                this->cols_ = screen::size().second;
+            }
+
+            const char* at = this->pbase() + this->observed_;
+            const char* end = this->pptr();
+            this->observed_ = this->size();
+            bool wrote_text = false;
+            // runs written shorter move the rest of the bytes back: everything before `copied` is already at its
+            // place, which ends at `moved`, `nullptr` until the first one
+            char* moved = nullptr;
+            const char* copied = at;
+            const bool runs = this->runs_ != RunEncoding::Literal && !this->cut_;
+            this->cut_ = false;
+            if (this->in_string_) {
+                at = Output::skip_string(at, end);
+                this->in_string_ = this->cut_ = (at == end);
+                // BEL ends it here, ST is a sequence on its own
+                if (at != end && *at == '\a') {
+                    ++at;
+                }
+            }
+            while (at != end) {
+                auto byte = static_cast<unsigned char>(*at++);
+                if (byte == static_cast<unsigned char>(ESC)) {
+                    if (at == end) {
+                        // cut in half, can't tell
+                        this->sgr_.invalidate();
+                        this->cursor_known_ = false;
+                        this->cut_ = true;
+                        break;
+                    }
+                    auto kind = *at++;
+                    if (kind == '[') {
+                        // CSI: parameters and intermediates, then the final byte in [0x40;0x7E]
+                        const char* params = at;
+                        while (at != end && (*at < 0x40 || *at > 0x7E)) {
+                            ++at;
+                        }
+                        if (at == end) {
+                            this->sgr_.invalidate();
+                            this->cursor_known_ = false;
+                            this->cut_ = true;
+                            break;
+                        }
+                        if (*at == 'm') {
+                            this->sgr_.invalidate_style();
+                            this->blank_ = Output::blank_after(this->blank_, params, at);
+                        } else if (*at == 'H') {
+                            this->row_ = Output::parse_param(params, at, 1);
+                            this->col_ = (*params == ';') ? Output::parse_param(++params, at, 1) : 1;
+                            this->cursor_known_ = (params == at);
+                        } else if (*at == 'G' && this->cursor_known_) {
+                            this->col_ = Output::parse_param(params, at, 1);
+                            this->cursor_known_ = (params == at);
+                        } else {
+                            this->cursor_known_ = false;
+                        }
+                        ++at;
+                    } else if (kind == ']' || kind == 'P' || kind == 'X' || kind == '^' || kind == '_') {
+                        // OSC, DCS, SOS, PM or APC: a body that ends with BEL or ESC '\', it mustn't be taken as text
+                        this->sgr_.invalidate();
+                        const char* body = at;
+                        at = Output::skip_string(at, end);
+                        this->in_string_ = this->cut_ = (at == end);
+                        if (this->in_string_) {
+                            // the rest comes with the next write, whatever it does
+                            this->cursor_known_ = false;
+                        }
+                        if (kind != ']') {
+                            // eg. sixel images move the cursor
+                            this->cursor_known_ = false;
+                            this->blank_ |= BLANK_ATTRS;
+                        } else if (at - body >= 2 && body[0] == '8' && body[1] == ';') {
+                            // OSC 8, a hyperlink: `8 ; params ; URI`, an empty URI closes the link
+                            const auto* uri = static_cast<const char*>(
+                                std::memchr(body + 2, ';', static_cast<size_t>(at - body - 2)));
+                            this->blank_ = (!this->in_string_ && uri != nullptr && uri + 1 == at)
+                                               ? this->blank_ & ~BLANK_LINK
+                                               : this->blank_ | BLANK_LINK;
+                        }
+                        if (at != end && *at == '\a') {
+                            ++at;
+                        }
+                    } else if (kind != '7' && kind != '\\') {
+                        // '8' restores the cursor and the style, 'c' resets the whole terminal, ...
+                        this->sgr_.invalidate();
+                        this->cursor_known_ = false;
+                        this->blank_ |= BLANK_ATTRS;
+                    }
+                } else if (byte < 0x20 || byte == 0x7F) {
+                    this->cursor_known_ = false;
+                } else if (byte >= 0x80) {
+                    const char* from = at - 1;
+                    if (unicode::utf8_len(*from) > static_cast<size_t>(end - from)) {
+                        // the rest comes with the next write
+                        this->cursor_known_ = false;
+                        this->cut_ = true;
+                        break;
+                    }
+                    auto width = unicode::width(unicode::decode(from, end));
+                    at = from;
+                    // it combines with the previous character, which might change its width, eg. emoji + U+FE0F
+                    if (width == 0) {
+                        this->cursor_known_ = false;
+                    }
+                    this->col_ += width;
+                    wrote_text = true;
+                } else {
+                    const char* from = at - 1;
+                    if (runs) {
+                        while (at != end && *at == *from) {
+                            ++at;
+                        }
+                    }
+                    auto count = static_cast<unsigned>(at - from);
+                    char seq[encode::MAX_SEQ];
+                    auto* seq_end =
+                        (count > 1) ? this->encode_run(seq, *from, count, (at != end) ? *at == ESC : moving) : seq;
+                    if (seq_end != seq) {
+                        if (moved == nullptr) {
+                            moved = this->pbase() + (from - this->pbase());
+                        } else {
+                            std::memmove(moved, copied, static_cast<size_t>(from - copied));
+                            moved += from - copied;
+                        }
+                        // shorter than the run, so it doesn't reach the bytes after it
+                        std::memcpy(moved, seq, static_cast<size_t>(seq_end - seq));
+                        moved += seq_end - seq;
+                        copied = at;
+                        ++this->stats_.runs;
+                        this->stats_.runs_bytes_saved += count - static_cast<size_t>(seq_end - seq);
+                    }
+                    this->col_ += count;
+                    wrote_text = true;
+                }
+            }
+            if (moved != nullptr) {
+                std::memmove(moved, copied, static_cast<size_t>(end - copied));
+                moved += end - copied;
+                this->pbump(-static_cast<int>(end - moved));
+                this->observed_ = this->size();
+            }
+            // past the last column the terminal waits to wrap, relative moves would be off by one
+            if (wrote_text && (this->cols_ == 0 || this->col_ > this->cols_)) {
+                this->cursor_known_ = false;
+            }
+        }
+
+        // `count` times the printable ascii `ch` at the cursor, with `runs_`, `escape_next` if a sequence follows
+        // returns: `out` if it's not shorter than writing it as it is
+        char* encode_run(char* out, char ch, unsigned count, bool escape_next) const {
+            char* start = out;
+            if (this->runs_ == RunEncoding::Repeat) {
+                *out++ = ch;
+                out = encode::csi_n(out, count - 1, 'b');
+            } else if (this->runs_ == RunEncoding::Erase && ch == ' ' && this->blank_ == 0 && this->cursor_known_ &&
+                       this->cols_ != 0 &&
+                       (this->col_ + count <= this->cols_ || (this->col_ + count == this->cols_ + 1 && escape_next))) {
+                // the move stops at the last column instead of waiting to wrap there, so a run reaching it is only
+                // the same if the next thing isn't text
+                out = encode::csi_n(out, count, 'X');
+                out = Output::csi_move(out, count, 'C');
+            }
+            return (static_cast<unsigned>(out - start) < count) ? out : start;
+        }
+
+        // shortest of the moves from column `from` to `col` on the same row
+        static char* column_move(char* out, unsigned from, unsigned col) {
+            if (col == from) {
+                return out;
+            }
+            if (col == 1) {
+                *out++ = '\r';
+                return out;
+            }
+            if (col + 1 == from) {
+                *out++ = '\b';
+                return out;
+            }
+            char rel[encode::MAX_SEQ];
+            auto* rel_end =
+                col > from ? Output::csi_move(rel, col - from, 'C') : Output::csi_move(rel, from - col, 'D');
+            auto* cha = encode::csi_n(out, col, 'G');
+            if (rel_end - rel < cha - out) {
+                std::memcpy(out, rel, static_cast<size_t>(rel_end - rel));
+                return out + (rel_end - rel);
+            }
+            return cha;
+        }
+
+        // CSI `n` `final`, leaving out `n` if it's the default 1
+        static char* csi_move(char* out, unsigned n, char final) {
+            if (n == 1) {
+                out = encode::literal(out, encode::PREFIX_CSI);
+                *out++ = final;
+                return out;
+            }
+            return encode::csi_n(out, n, final);
+        }
+
+        // make room for at least `n` more bytes, keeping the content
+        void reserve(size_t n) {
+            auto used = this->size();
+            if (HEADROOM + used + n <= this->buf_.size()) {
+                return;
+            }
+            auto cap = this->buf_.size() * 2;
+            this->buf_.resize(cap < HEADROOM + used + n ? HEADROOM + used + n : cap);
+            this->setp(this->buf_.data() + HEADROOM, this->buf_.data() + this->buf_.size());
+            this->pbump(static_cast<int>(used));
+        }
+
+        // write `n` bytes of `data` to the terminal, retrying partial writes
+        bool write_all(const char* data, size_t n) {
+            while (n > 0) {
+#ifdef _WIN32
+                DWORD done = 0;
+                ++this->stats_.syscalls;
+                if (WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), data, static_cast<DWORD>(n), &done, nullptr) == 0) {
+                    return false;
+                }
+#else
+                ++this->stats_.syscalls;
+                auto done = ::write(STDOUT_FILENO, data, n);
+                if (done < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+#endif
+                data += done;
+                n -= static_cast<size_t>(done);
+            }
+            return true;
+        }
+
+      protected:
+        int_type overflow(int_type ch) override {
+            if (traits_type::eq_int_type(ch, traits_type::eof())) {
+                return traits_type::not_eof(ch);
+            }
+            this->reserve(1);
+            *this->pptr() = traits_type::to_char_type(ch);
+            this->pbump(1);
+            return ch;
+        }
+        std::streamsize xsputn(const char* data, std::streamsize n) override {
+            this->append(data, static_cast<size_t>(n));
+            return n;
+        }
+        int sync() override { return this->flush() ? 0 : -1; }
+
+      public:
+        // `capacity`: bytes preallocated, the arena grows if a frame doesn't fit
+        explicit Output(size_t capacity = 1 << 16) : buf_(HEADROOM + (capacity == 0 ? 1 : capacity)) {
+            this->setp(this->buf_.data() + HEADROOM, this->buf_.data() + this->buf_.size());
+        }
+        Output(const Output&) = delete;
+        Output& operator=(const Output&) = delete;
+        ~Output() override { this->detach(); }
+
+        void append(const char* data, size_t n) {
+            this->reserve(n);
+            std::memcpy(this->pptr(), data, n);
+            // `pbump()` takes an `int`
+            while (n > 0) {
+                auto step = n > 1U << 30U ? 1U << 30U : n;
+                this->pbump(static_cast<int>(step));
+                n -= step;
+            }
+        }
+        void append(const std::string& data) { this->append(data.data(), data.size()); }
+
+        // switch the terminal to `style`, writing only the attributes and colors that change
+        // `style` is absolute: whatever it doesn't set is turned off
+        // NOTE: the state is only right if everything written to the terminal goes through this arena
+        void style(const Style& style) {
+            this->observe();
+            char buf[encode::MAX_SEQ];
+            this->append(buf, static_cast<size_t>(this->sgr_.style(buf, style) - buf));
+            this->observed_ = this->size();
+            using text::style::Style;
+            this->blank_ = (this->blank_ & BLANK_LINK) | (style.has(Style::underline) ? BLANK_UNDERLINE : 0) |
+                           (style.has(Style::inverted) ? BLANK_INVERTED : 0) |
+                           (style.has(Style::strikethrough) ? BLANK_STRIKETHROUGH : 0);
+        }
+        // open a hyperlink to `target` for whatever comes next, `""` closes it
+        void link(const std::string& target) {
+            this->observe();
+            this->append(this->sgr_.link(target));
+            this->observed_ = this->size();
+            this->blank_ = target.empty() ? this->blank_ & ~BLANK_LINK : this->blank_ | BLANK_LINK;
+        }
+        // move the cursor to (`row`;`col`), both starting at 1, with the shortest sequence:
+        // nothing if it's already there, CR, BS, LF, relative moves (CUU/CUD/CUF/CUB), CNL/CPL, CHA or CUP
+        // NOTE: the position is only right if everything written to the terminal goes through this arena
+        void move_to(unsigned row, unsigned col) {
+            this->observe(true);
+            char cup[encode::MAX_SEQ];
+            auto* cup_end = encode::cursor_position(cup, row, col);
+            if (row == 1 && col == 1) {
+                cup_end = encode::literal(cup, "\x1B[H");
+            }
+            const char* best = cup;
+            const char* best_end = cup_end;
+
+            char rel[encode::MAX_SEQ];
+            char line[encode::MAX_SEQ];
+            char* rel_end = rel;
+            if (this->cursor_known_) {
+                // vertical then horizontal
+                if (row > this->row_) {
+                    rel_end = Output::csi_move(rel, row - this->row_, 'B');
+                } else if (row < this->row_) {
+                    rel_end = Output::csi_move(rel, this->row_ - row, 'A');
+                }
+                rel_end = Output::column_move(rel_end, this->col_, col);
+                if (rel_end - rel < best_end - best) {
+                    best = rel;
+                    best_end = rel_end;
+                }
+
+                // to the start of a line, then horizontal: CR + LFs, CNL or CPL
+                char* line_end = line;
+                if (row > this->row_ && row - this->row_ <= 3) {
+                    *line_end++ = '\r';
+                    for (auto i = this->row_; i < row; ++i) {
+                        *line_end++ = '\n';
+                    }
+                } else if (row > this->row_) {
+                    line_end = Output::csi_move(line, row - this->row_, 'E');
+                } else if (row < this->row_) {
+                    line_end = Output::csi_move(line, this->row_ - row, 'F');
+                }
+                if (line_end != line) {
+                    line_end = Output::column_move(line_end, 1, col);
+                    if (line_end - line < best_end - best) {
+                        best = line;
+                        best_end = line_end;
+                    }
+                }
+            }
+
+            this->append(best, static_cast<size_t>(best_end - best));
+            this->observed_ = this->size();
+            this->row_ = row;
+            this->col_ = col;
+            this->cursor_known_ = true;
+            ++this->stats_.cursor_moves;
+            this->stats_.cursor_bytes_saved += static_cast<size_t>((cup_end - cup) - (best_end - best));
+        }
+        // forget where the cursor is and what style is on, eg. after resizing
+        void invalidate() {
+            this->observe();
+            this->cursor_known_ = false;
+            this->sgr_.invalidate();
+            this->blank_ |= BLANK_ATTRS;
+        }
+        // wrap every flush in a synchronized update (`CSI ?2026h` ... `CSI ?2026l`), so the terminal parses the whole
+        // frame before painting it once, instead of showing the half-drawn states
+        // NOTE: terminals not knowing it ignore it, but might still tear, see `supports_synchronized_output()`
+        void synchronized(bool enable) { this->synchronized_ = enable; }
+        bool synchronized() const { return this->synchronized_; }
+
+        // write runs of the same character shorter on flush: `RunEncoding::Repeat` if the terminal
+        // `supports_repeat()`, `RunEncoding::Erase` (only blanks) otherwise, pays off on slow links, eg. over ssh
+        // WARN: `RunEncoding::Erase` needs the terminal to erase with the current background color (bce), as most do
+        void runs(RunEncoding encoding) { this->runs_ = encoding; }
+        RunEncoding runs() const { return this->runs_; }
+
+        // the number of columns of the screen, needed to know when the cursor is waiting to wrap
+        // queried on `attach()`, update it when the screen is resized
+        void set_width(unsigned cols) { this->cols_ = cols; }
+        // 0 if unknown
+        unsigned width() const { return this->cols_; }
+
+        // write `text` with its style and link, leaving them on instead of resetting
+        void print(const tui::string& text) {
+            this->style(text.style());
+            this->link(text.link());
+            this->append(text.plain());
+            this->observe();
+        }
+        // what the terminal is drawing with
+        const SgrState& sgr() {
+            this->observe();
+            return this->sgr_;
+        }
+
+        // bytes waiting to be flushed
+        size_t size() const { return static_cast<size_t>(this->pptr() - this->pbase()); }
+
+        // write everything collected so far to the terminal
+        // returns: false if writing failed, the content is dropped either way
+        bool flush() {
+            if (this->size() == 0) {
+                return true;
+            }
+            this->observe();
+            const char* from = this->pbase();
+            if (this->synchronized_) {
+                // the terminal holds off painting until the end, so the frame shows up at once, without tearing
+                this->append("\x1B[?2026l", HEADROOM);
+                std::memcpy(this->buf_.data(), "\x1B[?2026h", HEADROOM);
+                from = this->buf_.data();
+            }
+            this->observed_ = 0;
+            this->stats_.bytes = static_cast<size_t>(this->pptr() - from);
+            this->stats_.syscalls = 0;
+            auto ok = this->write_all(from, this->stats_.bytes);
+            this->setp(this->buf_.data() + HEADROOM, this->buf_.data() + this->buf_.size());
+
+            this->stats_.total_bytes += this->stats_.bytes;
+            this->stats_.total_syscalls += this->stats_.syscalls;
+            ++this->stats_.flushes;
+            return ok;
+        }
+
+        // redirect `os` into this arena, flushing whatever it had buffered until now
+        void attach(std::ostream& os = std::cout) {
+            if (this->stream_ != nullptr) {
+                return;
+            }
+            os.flush();
+            this->sgr_.invalidate();
+            this->cursor_known_ = false;
+            this->blank_ |= BLANK_ATTRS;
+#ifndef _WIN32
+            struct winsize ws{};
+            if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
+                this->cols_ = ws.ws_col;
+            }
+#endif
+            this->stream_ = &os;
+            this->prev_ = os.rdbuf(this);
+        }
+        // flush and give the stream back its original buffer
+        void detach() {
+            if (this->stream_ == nullptr) {
+                return;
+            }
+            this->flush();
+            this->stream_->rdbuf(this->prev_);
+            this->stream_ = nullptr;
+            this->prev_ = nullptr;
+        }
+        bool attached() const { return this->stream_ != nullptr; }
+
+        const Stats& stats() const { return this->stats_; }
     };
 
+    // the arena used by the library, eg.: `tui::output().attach();` right after `tui::init()`
+    inline Output& output() {
+        static Output out;
+        return out;
+    }
+
+    namespace cursor {
+        // moves cursor to (`row`; `col`), with the shortest sequence if the output arena is attached, see
+        // `Output::move_to()`, otherwise same as `set_position()`
+        inline void move_to(unsigned row, unsigned col) {
+            if (output().attached()) {
+                output().move_to(row, col);
+            } else {
+                set_position(row, col);
+            }
+        }
+    } // namespace cursor
+
     // void handle_resize(int /*sig*/) { screen::clear(); }
     using fn_ptr = void (*)(int);
+    // the function given to `set_up_resize()`
+    inline std::atomic<fn_ptr>& resize_handler() {
+        static std::atomic<fn_ptr> handler{nullptr};
+        return handler;
+    }
     // WARN: does not work on windows
     // needs a void function, that takes an int
     // function pointer: `void function_name(int sig) { stuff }`
+    // NOTE: it's not called from the signal handler, but by `poll_resize()`, so it can do anything
     inline void set_up_resize(fn_ptr handle_resize) {
 #ifdef _WIN32
         // TODO: make it work, or at least try to
 #else
         // register the signal handler for SIGWINCH
-        struct sigaction sa{};
-        sa.sa_handler = handle_resize;
-        sa.sa_flags = SA_RESTART; // restart functions if interrupted by handler
-        sigaction(SIGWINCH, &sa, nullptr);
+        screen::size_cache();
+        resize_handler().store(handle_resize);
+#endif
+    }
+    // call the function given to `set_up_resize()` if the terminal was resized since the last call
+    // a burst of resizes (eg. dragging the window) means a single call
+    // returns: whether it was resized
+    inline bool poll_resize() {
+#ifdef _WIN32
+        return false;
+#else
+        static std::atomic<unsigned> polled_at{0};
+        auto count = screen::resizes().load();
+        if (polled_at.exchange(count) == count) {
+            return false;
+        }
+        auto handler = resize_handler().load();
+        if (handler != nullptr) {
+            handler(SIGWINCH);
+        }
+        return true;
 #endif
     }
 
@@ -455,10 +2122,100 @@ namespace tui {
         tui::screen::alternative_buffer(true);
         tui::screen::clear();
         tui::cursor::home();
+#ifndef _WIN32
+        term_state().alt_screen = true;
+        term_state().cursor_visible = enable_cursor;
+#endif
     }
     inline void reset() {
+        tui::output().detach();
+        tui::mouse::disable();
+        if (tui::bracketed_paste_enabled()) {
+            tui::bracketed_paste(false);
+        }
+        std::cout << tui::text::style::reset_style();
         tui::screen::alternative_buffer(false);
         tui::cursor::visible(true);
         tui::disable_raw_mode();
+#ifndef _WIN32
+        term_state().alt_screen = false;
+#endif
+    }
+
+    // give the terminal back as it was before `init()` and stop the process, like Ctrl+Z would in a shell
+    // once continued (eg. `fg`), raw mode and the alternate screen are set up again, no processes spawned
+    // NOTE: the screen has to be redrawn after that, see `resumed()`
+    // WARN: does nothing on windows
+    // it's async-signal-safe, so it can be (and is, by `set_up_suspend()`) called from a signal handler
+    inline void suspend() {
+#ifndef _WIN32
+        auto& state = term_state();
+        auto mouse = tui::mouse::tracking().load();
+        char seq[tui::encode::MAX_SEQ];
+        if (mouse != 0 && ::write(STDOUT_FILENO, seq, tui::mouse::encode(seq, mouse, false) - seq) < 0) {
+            // nothing to do about it
+        }
+        auto paste = tui::bracketed_paste_enabled().load();
+        if (paste && ::write(STDOUT_FILENO, "\x1B[?2004l", 8) < 0) {
+            // nothing to do about it
+        }
+        if (state.alt_screen) {
+            const char leave[] = "\x1B[0m\x1B[?1049l\x1B[?25h";
+            if (::write(STDOUT_FILENO, leave, sizeof(leave) - 1) < 0) {
+                // nothing to do about it
+            }
+        }
+        if (state.raw_enabled) {
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &state.orig);
+        }
+
+        raise(SIGSTOP);
+
+        // continued
+        if (state.raw_enabled) {
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &state.raw);
+        }
+        if (state.alt_screen) {
+            const char enter[] = "\x1B[?1049h\x1B[?25l";
+            // leave out hiding the cursor if it's visible
+            auto len = sizeof(enter) - (state.cursor_visible ? 7 : 1);
+            if (::write(STDOUT_FILENO, enter, len) < 0) {
+                // nothing to do about it
+            }
+        }
+        if (mouse != 0 && ::write(STDOUT_FILENO, seq, tui::mouse::encode(seq, mouse, true) - seq) < 0) {
+            // nothing to do about it
+        }
+        if (paste && ::write(STDOUT_FILENO, "\x1B[?2004h", 8) < 0) {
+            // nothing to do about it
+        }
+        state.resumed = 1;
+#endif
+    }
+
+    // was the process `suspend()`-ed and continued since the last call, meaning the screen has to be redrawn
+    inline bool resumed() {
+#ifdef _WIN32
+        return false;
+#else
+        if (term_state().resumed == 0) {
+            return false;
+        }
+        term_state().resumed = 0;
+        output().invalidate();
+        return true;
+#endif
+    }
+
+    // `suspend()` on SIGTSTP, eg. `kill -TSTP <pid>`
+    // NOTE: raw mode turns Ctrl+Z into `SpecKey::CtrlZ` instead of a signal, call `suspend()` on it yourself
+    // WARN: does not work on windows
+    inline void set_up_suspend() {
+#ifndef _WIN32
+        struct sigaction sa{};
+        sa.sa_handler = [](int /*sig*/) { suspend(); };
+        sa.sa_flags = SA_RESTART;
+        sigaction(SIGTSTP, &sa, nullptr);
+#endif
     }
 } // namespace tui